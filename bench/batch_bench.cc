@@ -0,0 +1,130 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+// Scans of a large batch of int results stored as
+// std::vector<ValueOrError<int>> and as ValueOrErrorBatch<int>: sum of the
+// values and indices of the failures. Runs once per error rate.
+#include <random>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "value_or_error.h"
+#include "value_or_error_batch.h"
+
+namespace {
+
+using rms::ValueOrError;
+using rms::ValueOrErrorBatch;
+using rms::bench::State;
+
+constexpr std::size_t BatchSize = 1U << 20U;
+
+// Fills batch with values and pseudo random failures
+template <typename Push>
+void fill(double error_rate, Push push) {
+  std::mt19937 generator(12345U);
+  std::bernoulli_distribution distribution(error_rate);
+  for (std::size_t i = 0U; i < BatchSize; ++i) {
+    if (distribution(generator)) {
+      push(ValueOrError<int>(std::errc::invalid_argument));
+    } else {
+      push(ValueOrError<int>(static_cast<int>(i & 0xffU)));
+    }
+  }
+}
+
+std::vector<ValueOrError<int>> make_vector(State& state) {
+  std::vector<ValueOrError<int>> results;
+  results.reserve(BatchSize);
+  fill(state.error_rate(), [&results](ValueOrError<int>&& result) {
+    results.push_back(std::move(result));
+  });
+  return results;
+}
+
+ValueOrErrorBatch<int> make_batch(State& state) {
+  ValueOrErrorBatch<int> batch;
+  batch.reserve(BatchSize);
+  fill(state.error_rate(), [&batch](ValueOrError<int>&& result) {
+    batch.push_back(std::move(result));
+  });
+  return batch;
+}
+
+// Builds the batch outside of measurement and reports items per iteration
+template <typename Make>
+auto prepare(State& state, Make make) -> decltype(make(state)) {
+  state.pause();
+  auto batch = make(state);
+  state.counter("items", static_cast<double>(BatchSize));
+  state.resume();
+  return batch;
+}
+
+void sum_vector(State& state) {
+  auto const results = prepare(state, make_vector);
+  std::size_t sum = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    for (auto const& result : results) {
+      if (result) {
+        sum += static_cast<std::size_t>(*result);
+      }
+    }
+  }
+  rms::bench::do_not_optimize(sum);
+}
+
+void sum_batch(State& state) {
+  auto const batch = prepare(state, make_batch);
+  std::size_t sum = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    batch.for_each_value([&sum](std::size_t, int value) {
+      sum += static_cast<std::size_t>(value);
+    });
+  }
+  rms::bench::do_not_optimize(sum);
+}
+
+void error_indices_vector(State& state) {
+  auto const results = prepare(state, make_vector);
+  std::vector<std::size_t> indices;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    indices.clear();
+    for (std::size_t j = 0U; j < results.size(); ++j) {
+      if (!results[j]) {
+        indices.push_back(j);
+      }
+    }
+    rms::bench::do_not_optimize(indices.data());
+  }
+}
+
+void error_indices_batch(State& state) {
+  auto const batch = prepare(state, make_batch);
+  std::vector<std::size_t> indices;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    indices.clear();
+    batch.for_each_error([&indices](std::size_t index, std::error_code) {
+      indices.push_back(index);
+    });
+    rms::bench::do_not_optimize(indices.data());
+  }
+}
+
+void add(std::string const& name, rms::bench::BenchmarkFn fn) {
+  rms::bench::registry().push_back({"Batch" + name, std::move(fn), true});
+}
+
+struct Registration {
+  Registration() {
+    add("SumValues/Vector", sum_vector);
+    add("SumValues/Batch", sum_batch);
+    add("ErrorIndices/Vector", error_indices_vector);
+    add("ErrorIndices/Batch", error_indices_batch);
+  }
+};
+
+Registration const registration;
+
+}  // namespace
@@ -0,0 +1,100 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+// Partition kernels over a batch of 1M results with 4 and 8 byte values for
+// each SIMD level supported by the CPU. Runs once per error rate.
+#include <cstdint>
+#include <random>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "batch_simd.h"
+#include "bench.h"
+#include "value_or_error_batch.h"
+
+namespace {
+
+using rms::SimdLevel;
+using rms::ValueOrErrorBatch;
+using rms::bench::State;
+
+constexpr std::size_t BatchSize = 1U << 20U;
+
+template <typename T>
+ValueOrErrorBatch<T> make_batch(State& state) {
+  state.pause();
+  std::mt19937 generator(12345U);
+  std::bernoulli_distribution distribution(state.error_rate());
+  ValueOrErrorBatch<T> batch;
+  batch.reserve(BatchSize);
+  for (std::size_t i = 0U; i < BatchSize; ++i) {
+    if (distribution(generator)) {
+      batch.push_error(std::make_error_code(std::errc::invalid_argument));
+    } else {
+      batch.emplace_value(static_cast<T>(i));
+    }
+  }
+  state.counter("items", static_cast<double>(BatchSize));
+  state.resume();
+  return batch;
+}
+
+template <typename T, SimdLevel Level>
+void count_errors(State& state) {
+  auto const batch = make_batch<T>(state);
+  std::size_t sum = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    rms::bench::clobber_memory();
+    sum += rms::count_errors(batch, Level);
+  }
+  rms::bench::do_not_optimize(sum);
+}
+
+template <typename T, SimdLevel Level>
+void compact_values(State& state) {
+  auto const batch = make_batch<T>(state);
+  std::vector<T> values(batch.value_count());
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    rms::bench::do_not_optimize(
+        rms::compact_values(batch, values.data(), Level));
+    rms::bench::clobber_memory();
+  }
+}
+
+template <typename T, SimdLevel Level>
+void error_indices(State& state) {
+  auto const batch = make_batch<T>(state);
+  std::vector<std::uint32_t> indices(batch.error_count());
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    rms::bench::do_not_optimize(
+        rms::error_indices(batch, indices.data(), Level));
+    rms::bench::clobber_memory();
+  }
+}
+
+void add(std::string const& name, rms::bench::BenchmarkFn fn) {
+  rms::bench::registry().push_back({"BatchSimd" + name, std::move(fn), true});
+}
+
+template <SimdLevel Level>
+void add_level(std::string const& level) {
+  if (!rms::simd_supported(Level)) {
+    return;
+  }
+  add("CountErrors/" + level, count_errors<std::uint32_t, Level>);
+  add("CompactValues/Int32/" + level, compact_values<std::uint32_t, Level>);
+  add("CompactValues/Int64/" + level, compact_values<std::uint64_t, Level>);
+  add("ErrorIndices/" + level, error_indices<std::uint32_t, Level>);
+}
+
+struct Registration {
+  Registration() {
+    add_level<SimdLevel::Scalar>("Scalar");
+    add_level<SimdLevel::Sse42>("Sse42");
+    add_level<SimdLevel::Avx2>("Avx2");
+  }
+};
+
+Registration const registration;
+
+}  // namespace
@@ -0,0 +1,235 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#pragma once
+
+/*
+ * Minimal self-contained benchmark harness.
+ * Every benchmark is a function which runs its body state.iterations() times.
+ * Runner picks the number of iterations to fill the requested minimal time.
+ */
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "try.h"
+
+namespace rms {
+namespace bench {
+
+// Prevents compiler from optimizing away computation of the value.
+template <typename T>
+inline void do_not_optimize(T const& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Forces compiler to flush all pending writes to memory.
+inline void clobber_memory() { asm volatile("" : : : "memory"); }
+
+// Hardware counters of the calling thread, user space only. Every counter is
+// opened on its own, so a counter which is not supported does not disable the
+// others. Counters are unavailable outside of Linux, when perf events are
+// forbidden (perf_event_paranoid) or not supported (VMs without PMU). Reads
+// of unavailable counters are always 0.
+class PerfCounters {
+ public:
+  enum Event {
+    Cycles,
+    Instructions,
+    Branches,
+    BranchMisses,
+    L1dMisses,
+    EventsCount
+  };
+
+  using Values = std::array<std::uint64_t, EventsCount>;
+
+  explicit PerfCounters(bool enabled) {
+    for (std::size_t i = 0U; i < EventsCount; ++i) {
+      m_fds[i] = enabled ? open(static_cast<Event>(i)) : -1;
+    }
+  }
+
+  PerfCounters(PerfCounters const&) = delete;
+  PerfCounters& operator=(PerfCounters const&) = delete;
+
+  ~PerfCounters() {
+#if defined(__linux__)
+    for (auto const fd : m_fds) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+#endif
+  }
+
+  static char const* name(Event event) noexcept {
+    static char const* const names[EventsCount] = {
+        "cycles", "instructions", "branches", "branch_misses", "l1d_misses"};
+    return names[event];
+  }
+
+  bool available(Event event) const noexcept { return m_fds[event] >= 0; }
+
+  Values read() const noexcept {
+    Values values{};
+#if defined(__linux__)
+    for (std::size_t i = 0U; i < EventsCount; ++i) {
+      if (m_fds[i] >= 0 &&
+          ::read(m_fds[i], &values[i], sizeof(values[i])) !=
+              sizeof(values[i])) {
+        values[i] = 0U;
+      }
+    }
+#endif
+    return values;
+  }
+
+ private:
+  static int open(Event event) noexcept {
+#if defined(__linux__)
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    switch (event) {
+      case Cycles:
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+      case Instructions:
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+      case Branches:
+        attr.config = PERF_COUNT_HW_BRANCH_INSTRUCTIONS;
+        break;
+      case BranchMisses:
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+      case L1dMisses:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_L1D |
+                      (PERF_COUNT_HW_CACHE_OP_READ << 8U) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16U);
+        break;
+      default:
+        return -1;
+    }
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+    static_cast<void>(event);
+    return -1;
+#endif
+  }
+
+  std::array<int, EventsCount> m_fds;
+};
+
+class State {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit State(std::size_t iterations, double error_rate = 0.0,
+                 bool perf_counters = false)
+      : m_iterations(iterations),
+        m_error_rate(error_rate),
+        m_perf_counters(perf_counters) {}
+
+  std::size_t iterations() const noexcept { return m_iterations; }
+
+  // Share of operations which should fail, in [0, 1]. Set by the runner for
+  // benchmarks registered with error rates.
+  double error_rate() const noexcept { return m_error_rate; }
+
+  // Exclude setup or teardown code from the measurement.
+  void pause() {
+    m_elapsed += Clock::now() - m_started;
+    auto const values = m_perf_counters.read();
+    for (std::size_t i = 0U; i < values.size(); ++i) {
+      m_perf_values[i] += values[i] - m_perf_started[i];
+    }
+  }
+
+  void resume() {
+    m_perf_started = m_perf_counters.read();
+    m_started = Clock::now();
+  }
+
+  // Arbitrary named number reported next to the timing, e.g. copies of T.
+  void counter(std::string const& name, double value) {
+    m_counters[name] = value;
+  }
+
+  void start() {
+    m_elapsed = Clock::duration::zero();
+    m_perf_values.fill(0U);
+    resume();
+  }
+
+  void stop() { pause(); }
+
+  Clock::duration elapsed() const noexcept { return m_elapsed; }
+
+  PerfCounters const& perf_counters() const noexcept { return m_perf_counters; }
+
+  // Total of the measured code
+  std::uint64_t perf_value(PerfCounters::Event event) const noexcept {
+    return m_perf_values[event];
+  }
+
+  std::map<std::string, double> const& counters() const noexcept {
+    return m_counters;
+  }
+
+ private:
+  std::size_t m_iterations;
+  double m_error_rate;
+  Clock::time_point m_started;
+  Clock::duration m_elapsed = Clock::duration::zero();
+  PerfCounters m_perf_counters;
+  PerfCounters::Values m_perf_started{};
+  PerfCounters::Values m_perf_values{};
+  std::map<std::string, double> m_counters;
+};
+
+using BenchmarkFn = std::function<void(State&)>;
+
+struct Benchmark {
+  std::string name;
+  BenchmarkFn fn;
+  // Run once per error rate given to the runner
+  bool with_error_rates;
+};
+
+inline std::vector<Benchmark>& registry() {
+  static std::vector<Benchmark> benchmarks;
+  return benchmarks;
+}
+
+struct Registrar {
+  Registrar(std::string name, BenchmarkFn fn, bool with_error_rates = false) {
+    registry().push_back({std::move(name), std::move(fn), with_error_rates});
+  }
+};
+
+}  // namespace bench
+}  // namespace rms
+
+#define VOE_BENCHMARK(name)                                           \
+  static void name(::rms::bench::State& state);                      \
+  static ::rms::bench::Registrar VOE_TRY_GLUE(name, _registrar){#name, \
+                                                               name}; \
+  static void name(::rms::bench::State& state)
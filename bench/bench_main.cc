@@ -0,0 +1,215 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+
+namespace {
+
+struct Options {
+  std::string filter;
+  double min_time = 0.2;
+  // In percent
+  std::vector<double> error_rates = {0.0, 0.1, 10.0};
+  bool perf_counters = false;
+  std::string json_path;
+};
+
+// Measurements of one case. Values are per iteration.
+struct Result {
+  std::string name;
+  double error_rate;
+  std::size_t iterations;
+  double time_ns;
+  std::vector<std::pair<std::string, double>> perf;
+  std::map<std::string, double> counters;
+};
+
+std::vector<double> parse_list(std::string const& list) {
+  std::vector<double> result;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    result.push_back(std::strtod(item.c_str(), nullptr));
+  }
+  return result;
+}
+
+Options parse_options(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg = argv[i];
+    std::string const filter_key = "--filter=";
+    std::string const min_time_key = "--min-time=";
+    std::string const error_rates_key = "--error-rates=";
+    std::string const json_key = "--json=";
+    if (arg.compare(0, filter_key.size(), filter_key) == 0) {
+      options.filter = arg.substr(filter_key.size());
+    } else if (arg.compare(0, min_time_key.size(), min_time_key) == 0) {
+      options.min_time =
+          std::strtod(arg.c_str() + min_time_key.size(), nullptr);
+    } else if (arg.compare(0, error_rates_key.size(), error_rates_key) == 0) {
+      options.error_rates = parse_list(arg.substr(error_rates_key.size()));
+    } else if (arg == "--perf-counters") {
+      options.perf_counters = true;
+    } else if (arg.compare(0, json_key.size(), json_key) == 0) {
+      options.json_path = arg.substr(json_key.size());
+    } else {
+      std::fprintf(stderr,
+                   "Usage: %s [--filter=<substr>] [--min-time=<sec>] "
+                   "[--error-rates=<pct>,<pct>...] [--perf-counters] "
+                   "[--json=<file>]\n",
+                   argv[0]);
+      std::exit(EXIT_FAILURE);
+    }
+  }
+  return options;
+}
+
+void warn_unavailable_counters() {
+  using rms::bench::PerfCounters;
+  PerfCounters const counters(true);
+  for (std::size_t i = 0U; i < PerfCounters::EventsCount; ++i) {
+    auto const event = static_cast<PerfCounters::Event>(i);
+    if (!counters.available(event)) {
+      std::fprintf(stderr, "Perf counter %s is not available\n",
+                   PerfCounters::name(event));
+    }
+  }
+}
+
+Result measure(rms::bench::Benchmark const& benchmark, std::string const& name,
+               double error_rate, Options const& options) {
+  using Seconds = std::chrono::duration<double>;
+  using rms::bench::PerfCounters;
+  constexpr std::size_t MaxIterations = 1000000000U;
+
+  std::size_t iterations = 1U;
+  for (;;) {
+    rms::bench::State state(iterations, error_rate, options.perf_counters);
+    state.start();
+    benchmark.fn(state);
+    state.stop();
+
+    auto const elapsed = std::chrono::duration_cast<Seconds>(state.elapsed());
+    if (elapsed.count() >= options.min_time || iterations >= MaxIterations) {
+      auto const count = static_cast<double>(iterations);
+      Result result{name,
+                    error_rate,
+                    iterations,
+                    elapsed.count() * 1e9 / count,
+                    {},
+                    state.counters()};
+      for (std::size_t i = 0U; i < PerfCounters::EventsCount; ++i) {
+        auto const event = static_cast<PerfCounters::Event>(i);
+        if (state.perf_counters().available(event)) {
+          result.perf.emplace_back(
+              PerfCounters::name(event),
+              static_cast<double>(state.perf_value(event)) / count);
+        }
+      }
+      return result;
+    }
+    iterations *= 10U;
+  }
+}
+
+void print(Result const& result) {
+  std::printf("%-56s %12zu %12.2f ns", result.name.c_str(), result.iterations,
+              result.time_ns);
+  for (auto const& perf : result.perf) {
+    std::printf("  %s=%.1f", perf.first.c_str(), perf.second);
+  }
+  for (auto const& counter : result.counters) {
+    std::printf("  %s=%g", counter.first.c_str(), counter.second);
+  }
+  std::printf("\n");
+}
+
+std::string json_string(std::string const& value) {
+  std::string result = "\"";
+  for (auto const c : value) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+    }
+    result += c;
+  }
+  return result + "\"";
+}
+
+template <typename Pairs>
+void write_json_object(std::ostream& output, Pairs const& pairs) {
+  output << "{";
+  char const* separator = "";
+  for (auto const& pair : pairs) {
+    output << separator << json_string(pair.first) << ": " << pair.second;
+    separator = ", ";
+  }
+  output << "}";
+}
+
+// One object per case. Perf counters which are not available are omitted.
+bool write_json(std::string const& path, std::vector<Result> const& results) {
+  std::ofstream output(path);
+  output.precision(10);
+  output << "[\n";
+  char const* separator = "";
+  for (auto const& result : results) {
+    output << separator << "  {\"name\": " << json_string(result.name)
+           << ", \"error_rate\": " << result.error_rate
+           << ", \"iterations\": " << result.iterations
+           << ", \"time_ns\": " << result.time_ns << ", \"perf\": ";
+    write_json_object(output, result.perf);
+    output << ", \"counters\": ";
+    write_json_object(output, result.counters);
+    output << "}";
+    separator = ",\n";
+  }
+  output << "\n]\n";
+  return static_cast<bool>(output);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  auto const options = parse_options(argc, argv);
+  std::vector<Result> results;
+  auto const run = [&options, &results](rms::bench::Benchmark const& benchmark,
+                                        std::string const& name,
+                                        double error_rate) {
+    if (name.find(options.filter) != std::string::npos) {
+      results.push_back(measure(benchmark, name, error_rate, options));
+      print(results.back());
+    }
+  };
+
+  if (options.perf_counters) {
+    warn_unavailable_counters();
+  }
+
+  std::printf("%-56s %12s %15s\n", "Benchmark", "Iterations", "Time/iter");
+  for (auto const& benchmark : rms::bench::registry()) {
+    if (!benchmark.with_error_rates) {
+      run(benchmark, benchmark.name, 0.0);
+      continue;
+    }
+    for (auto const error_rate : options.error_rates) {
+      char suffix[32];
+      std::snprintf(suffix, sizeof(suffix), "/err=%g%%", error_rate);
+      run(benchmark, benchmark.name + suffix, error_rate / 100.0);
+    }
+  }
+
+  if (!options.json_path.empty() && !write_json(options.json_path, results)) {
+    std::fprintf(stderr, "Failed to write %s\n", options.json_path.c_str());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
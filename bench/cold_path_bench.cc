@@ -0,0 +1,77 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+// Happy path cost of error propagation through three layers at 0.1% and 10%
+// error rates. Build with -DVOE_BRANCH_HINTS=0 to get the numbers without
+// branch hints and cold error paths.
+#include <cstdint>
+#include <system_error>
+#include <vector>
+
+#include "bench.h"
+#include "try.h"
+#include "value_or_error.h"
+
+namespace {
+
+using Result = rms::ValueOrError<int>;
+
+constexpr std::size_t InputsCount = 1U << 16U;
+
+// Pseudo random inputs, so the branch predictor can't learn the pattern.
+// Negative input is an error. Rate is in errors per 100000.
+std::vector<int> make_inputs(std::uint32_t rate) {
+  std::vector<int> inputs(InputsCount);
+  std::uint32_t seed = 12345U;
+  for (auto& input : inputs) {
+    seed = seed * 1664525U + 1013904223U;
+    input = (seed >> 8U) % 100000U < rate ? -1 : static_cast<int>(seed & 0xffU);
+  }
+  return inputs;
+}
+
+__attribute__((noinline)) Result parse(int input) {
+  if (input < 0) {
+    return std::make_error_code(std::errc::invalid_argument);
+  }
+  return input;
+}
+
+__attribute__((noinline)) Result validate(int input) {
+  VOE_TRY_EXTRACT(value, parse(input));
+  return value + 1;
+}
+
+__attribute__((noinline)) Result compute(int input) {
+  VOE_TRY_EXTRACT(value, validate(input));
+  return value * 2;
+}
+
+__attribute__((noinline)) Result compute_then(int input) {
+  return parse(input)
+      .then([](int value) { return Result(value + 1); })
+      .then([](int value) { return Result(value * 2); });
+}
+
+template <Result (*Compute)(int)>
+void run(rms::bench::State& state, std::uint32_t rate) {
+  auto const inputs = make_inputs(rate);
+  int sum = 0;
+  std::size_t errors = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    auto const result = Compute(inputs[i & (InputsCount - 1U)]);
+    if (result) {
+      sum += result.value();
+    } else {
+      ++errors;
+    }
+  }
+  rms::bench::do_not_optimize(sum);
+  state.counter("error_rate_pct", 100.0 * static_cast<double>(errors) /
+                                      static_cast<double>(state.iterations()));
+}
+
+}  // namespace
+
+VOE_BENCHMARK(ColdPathTryRate0_1) { run<compute>(state, 100U); }
+VOE_BENCHMARK(ColdPathTryRate10) { run<compute>(state, 10000U); }
+VOE_BENCHMARK(ColdPathThenRate0_1) { run<compute_then>(state, 100U); }
+VOE_BENCHMARK(ColdPathThenRate10) { run<compute_then>(state, 10000U); }
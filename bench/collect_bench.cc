@@ -0,0 +1,130 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+// Lookup over a batch of keys collected into ValueOrError<std::vector<T>>:
+// a hand-written loop with extract(), transform_collect() and
+// transform_collect() into a reused output buffer. Payloads are int and
+// std::string.
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "collect.h"
+#include "value_or_error.h"
+
+namespace {
+
+using rms::ValueOrError;
+
+constexpr std::size_t Keys = 1024U;
+
+template <typename T>
+struct Lookup;
+
+template <>
+struct Lookup<int> {
+  static ValueOrError<int> find(std::size_t key) {
+    if (key >= Keys) {
+      return std::make_error_code(std::errc::result_out_of_range);
+    }
+    return static_cast<int>(key & 0xffU);
+  }
+  static std::size_t weight(int value) {
+    return static_cast<std::size_t>(value);
+  }
+};
+
+template <>
+struct Lookup<std::string> {
+  static ValueOrError<std::string> find(std::size_t key) {
+    if (key >= Keys) {
+      return std::make_error_code(std::errc::result_out_of_range);
+    }
+    return std::string("customer name which is long enough");
+  }
+  static std::size_t weight(std::string const& value) { return value.size(); }
+};
+
+std::vector<std::size_t> const& keys() {
+  static std::vector<std::size_t> const instance = [] {
+    std::vector<std::size_t> result(Keys);
+    for (std::size_t i = 0U; i < Keys; ++i) {
+      result[i] = i;
+    }
+    return result;
+  }();
+  return instance;
+}
+
+template <typename T>
+__attribute__((noinline)) ValueOrError<std::vector<T>> hand_loop(
+    std::vector<std::size_t> const& ids) {
+  std::vector<T> values;
+  for (auto const id : ids) {
+    auto value = Lookup<T>::find(id);
+    if (!value) {
+      return value.error();
+    }
+    values.push_back(value.extract());
+  }
+  return values;
+}
+
+template <typename T>
+__attribute__((noinline)) ValueOrError<std::vector<T>> collected(
+    std::vector<std::size_t> const& ids) {
+  return rms::transform_collect(
+      ids, [](std::size_t id) { return Lookup<T>::find(id); });
+}
+
+template <typename T>
+std::size_t weight(std::vector<T> const& values) {
+  std::size_t sum = 0U;
+  for (auto const& value : values) {
+    sum += Lookup<T>::weight(value);
+  }
+  return sum;
+}
+
+template <typename T,
+          ValueOrError<std::vector<T>> (*Collect)(
+              std::vector<std::size_t> const&)>
+void run(rms::bench::State& state) {
+  std::size_t sum = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    auto const result = Collect(keys());
+    if (result) {
+      sum += weight(result.value());
+    }
+  }
+  rms::bench::do_not_optimize(sum);
+  state.counter("items", static_cast<double>(Keys));
+}
+
+template <typename T>
+void run_buffered(rms::bench::State& state) {
+  std::vector<T> values;
+  std::size_t sum = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    if (rms::transform_collect(keys(), Lookup<T>::find, values)) {
+      sum += weight(values);
+    }
+  }
+  rms::bench::do_not_optimize(sum);
+  state.counter("items", static_cast<double>(Keys));
+}
+
+}  // namespace
+
+VOE_BENCHMARK(CollectHandLoopInt) { run<int, hand_loop<int>>(state); }
+VOE_BENCHMARK(CollectTransformInt) { run<int, collected<int>>(state); }
+VOE_BENCHMARK(CollectTransformBufferInt) { run_buffered<int>(state); }
+VOE_BENCHMARK(CollectHandLoopString) {
+  run<std::string, hand_loop<std::string>>(state);
+}
+VOE_BENCHMARK(CollectTransformString) {
+  run<std::string, collected<std::string>>(state);
+}
+VOE_BENCHMARK(CollectTransformBufferString) {
+  run_buffered<std::string>(state);
+}
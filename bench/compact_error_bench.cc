@@ -0,0 +1,52 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+// Memory and time of a large batch of results with std::error_code and with
+// the 32 bit CompactErrorCode.
+#include <system_error>
+#include <vector>
+
+#include "bench.h"
+#include "compact_error.h"
+#include "value_or_error.h"
+
+namespace {
+
+constexpr std::size_t ResultsCount = 10000000U;
+// Every ErrorPeriod-th result is an error
+constexpr std::size_t ErrorPeriod = 100U;
+
+template <typename Result>
+void fill_batch(rms::bench::State& state) {
+  std::size_t succeeded = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    std::vector<Result> batch;
+    batch.reserve(ResultsCount);
+    for (std::size_t j = 0U; j < ResultsCount; ++j) {
+      if (j % ErrorPeriod == 0U) {
+        batch.emplace_back(std::make_error_code(std::errc::invalid_argument));
+      } else {
+        batch.emplace_back((j & 1U) != 0U);
+      }
+    }
+    rms::bench::clobber_memory();
+    for (auto const& result : batch) {
+      if (result) {
+        ++succeeded;
+      }
+    }
+    rms::bench::do_not_optimize(batch.data());
+  }
+  rms::bench::do_not_optimize(succeeded);
+  auto const batch_bytes = static_cast<double>(sizeof(Result) * ResultsCount);
+  state.counter("bytes_per_result", sizeof(Result));
+  state.counter("batch_mib", batch_bytes / (1024.0 * 1024.0));
+}
+
+}  // namespace
+
+VOE_BENCHMARK(CompactErrorFillBatch) {
+  fill_batch<rms::CompactValueOrError<bool>>(state);
+}
+
+VOE_BENCHMARK(CompactErrorFillBatchErrorCode) {
+  fill_batch<rms::ValueOrError<bool>>(state);
+}
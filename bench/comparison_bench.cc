@@ -0,0 +1,506 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+// Cost of ValueOrError compared with other ways to report errors:
+// exceptions, std::error_code out-parameters and std::optional (which loses
+// the error). Every operation is measured for int, std::string and
+// std::vector<std::string> payloads at error rates given to the runner.
+//
+// Construct: a function returns a payload or an error, the caller checks it.
+// Then: the result goes through three steps which may propagate the error.
+// Try: an error is propagated through Layers nested calls (VOE_TRY_EXTRACT).
+// Destroy: a batch of results is destroyed; construction is not measured.
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "try.h"
+#include "value_or_error.h"
+
+namespace {
+
+using rms::bench::State;
+
+constexpr std::size_t PatternSize = 1U << 14U;
+constexpr int Layers = 8;
+constexpr std::size_t BatchSize = 1024U;
+
+// Pseudo random failures, so the branch predictor can't learn the pattern
+class Failures {
+ public:
+  explicit Failures(double rate) : m_pattern(PatternSize) {
+    std::mt19937 generator(12345U);
+    std::bernoulli_distribution distribution(rate);
+    for (auto& failure : m_pattern) {
+      failure = distribution(generator) ? 1U : 0U;
+    }
+  }
+
+  bool operator[](std::size_t i) const {
+    return m_pattern[i & (PatternSize - 1U)] != 0U;
+  }
+
+ private:
+  std::vector<std::uint8_t> m_pattern;
+};
+
+std::error_code failure() {
+  return std::make_error_code(std::errc::invalid_argument);
+}
+
+template <typename T>
+struct Payload;
+
+template <>
+struct Payload<int> {
+  static int make(std::size_t i) { return static_cast<int>(i & 0xffU); }
+  static int step(int value) { return value + 1; }
+  static std::size_t weight(int value) {
+    return static_cast<std::size_t>(value);
+  }
+};
+
+template <>
+struct Payload<std::string> {
+  // Does not fit into small string buffer
+  static std::string make(std::size_t) {
+    return "customer name which is long enough";
+  }
+  static std::string step(std::string&& value) { return std::move(value); }
+  static std::size_t weight(std::string const& value) { return value.size(); }
+};
+
+template <>
+struct Payload<std::vector<std::string>> {
+  static std::vector<std::string> make(std::size_t) {
+    return {"first customer name", "second customer name",
+            "third customer name", "fourth customer name"};
+  }
+  static std::vector<std::string> step(std::vector<std::string>&& value) {
+    return std::move(value);
+  }
+  static std::size_t weight(std::vector<std::string> const& value) {
+    return value.size();
+  }
+};
+
+void report(State& state, std::size_t sum, std::size_t errors) {
+  rms::bench::do_not_optimize(sum);
+  state.counter("errors_pct", 100.0 * static_cast<double>(errors) /
+                                  static_cast<double>(state.iterations()));
+}
+
+// Sources of payloads or errors, one per style
+
+template <typename T>
+__attribute__((noinline)) rms::ValueOrError<T> voe_make(bool fail,
+                                                        std::size_t i) {
+  if (fail) {
+    return failure();
+  }
+  return Payload<T>::make(i);
+}
+
+template <typename T>
+__attribute__((noinline)) T exception_make(bool fail, std::size_t i) {
+  if (fail) {
+    throw std::system_error(failure());
+  }
+  return Payload<T>::make(i);
+}
+
+template <typename T>
+__attribute__((noinline)) void code_make(bool fail, std::size_t i, T& out,
+                                         std::error_code& error) {
+  if (fail) {
+    error = failure();
+    return;
+  }
+  out = Payload<T>::make(i);
+}
+
+template <typename T>
+__attribute__((noinline)) std::optional<T> optional_make(bool fail,
+                                                        std::size_t i) {
+  if (fail) {
+    return std::nullopt;
+  }
+  return Payload<T>::make(i);
+}
+
+// Construct
+
+template <typename T>
+void construct_voe(State& state) {
+  Failures const failures(state.error_rate());
+  std::size_t sum = 0U;
+  std::size_t errors = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    auto const result = voe_make<T>(failures[i], i);
+    if (result) {
+      sum += Payload<T>::weight(result.value());
+    } else {
+      ++errors;
+    }
+  }
+  report(state, sum, errors);
+}
+
+template <typename T>
+void construct_exception(State& state) {
+  Failures const failures(state.error_rate());
+  std::size_t sum = 0U;
+  std::size_t errors = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    try {
+      auto const result = exception_make<T>(failures[i], i);
+      sum += Payload<T>::weight(result);
+    } catch (std::system_error const&) {
+      ++errors;
+    }
+  }
+  report(state, sum, errors);
+}
+
+template <typename T>
+void construct_code(State& state) {
+  Failures const failures(state.error_rate());
+  std::size_t sum = 0U;
+  std::size_t errors = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    T result{};
+    std::error_code error;
+    code_make<T>(failures[i], i, result, error);
+    if (!error) {
+      sum += Payload<T>::weight(result);
+    } else {
+      ++errors;
+    }
+  }
+  report(state, sum, errors);
+}
+
+template <typename T>
+void construct_optional(State& state) {
+  Failures const failures(state.error_rate());
+  std::size_t sum = 0U;
+  std::size_t errors = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    auto const result = optional_make<T>(failures[i], i);
+    if (result) {
+      sum += Payload<T>::weight(*result);
+    } else {
+      ++errors;
+    }
+  }
+  report(state, sum, errors);
+}
+
+// Then: three steps after the source
+
+template <typename T>
+void then_voe(State& state) {
+  Failures const failures(state.error_rate());
+  auto const step = [](T& value) {
+    return rms::ValueOrError<T>(Payload<T>::step(std::move(value)));
+  };
+  std::size_t sum = 0U;
+  std::size_t errors = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    auto const result =
+        voe_make<T>(failures[i], i).then(step).then(step).then(step);
+    if (result) {
+      sum += Payload<T>::weight(result.value());
+    } else {
+      ++errors;
+    }
+  }
+  report(state, sum, errors);
+}
+
+template <typename T>
+void then_exception(State& state) {
+  Failures const failures(state.error_rate());
+  std::size_t sum = 0U;
+  std::size_t errors = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    try {
+      auto const result = Payload<T>::step(Payload<T>::step(
+          Payload<T>::step(exception_make<T>(failures[i], i))));
+      sum += Payload<T>::weight(result);
+    } catch (std::system_error const&) {
+      ++errors;
+    }
+  }
+  report(state, sum, errors);
+}
+
+template <typename T>
+void then_code(State& state) {
+  Failures const failures(state.error_rate());
+  std::size_t sum = 0U;
+  std::size_t errors = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    T result{};
+    std::error_code error;
+    code_make<T>(failures[i], i, result, error);
+    for (int step = 0; step < 3 && !error; ++step) {
+      result = Payload<T>::step(std::move(result));
+    }
+    if (!error) {
+      sum += Payload<T>::weight(result);
+    } else {
+      ++errors;
+    }
+  }
+  report(state, sum, errors);
+}
+
+template <typename T>
+void then_optional(State& state) {
+  Failures const failures(state.error_rate());
+  auto const step = [](std::optional<T>&& value) -> std::optional<T> {
+    if (!value) {
+      return std::nullopt;
+    }
+    return Payload<T>::step(std::move(*value));
+  };
+  std::size_t sum = 0U;
+  std::size_t errors = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    auto const result = step(step(step(optional_make<T>(failures[i], i))));
+    if (result) {
+      sum += Payload<T>::weight(*result);
+    } else {
+      ++errors;
+    }
+  }
+  report(state, sum, errors);
+}
+
+// Try: propagation through Layers nested calls
+
+template <typename T, int N>
+__attribute__((noinline)) rms::ValueOrError<T> voe_layer(bool fail,
+                                                         std::size_t i) {
+  if constexpr (N == 0) {
+    return voe_make<T>(fail, i);
+  } else {
+    VOE_TRY_EXTRACT(value, voe_layer<T, N - 1>(fail, i));
+    return Payload<T>::step(std::move(value));
+  }
+}
+
+template <typename T, int N>
+__attribute__((noinline)) T exception_layer(bool fail, std::size_t i) {
+  if constexpr (N == 0) {
+    return exception_make<T>(fail, i);
+  } else {
+    return Payload<T>::step(exception_layer<T, N - 1>(fail, i));
+  }
+}
+
+template <typename T, int N>
+__attribute__((noinline)) void code_layer(bool fail, std::size_t i, T& out,
+                                          std::error_code& error) {
+  if constexpr (N == 0) {
+    code_make<T>(fail, i, out, error);
+  } else {
+    code_layer<T, N - 1>(fail, i, out, error);
+    if (error) {
+      return;
+    }
+    out = Payload<T>::step(std::move(out));
+  }
+}
+
+template <typename T, int N>
+__attribute__((noinline)) std::optional<T> optional_layer(bool fail,
+                                                         std::size_t i) {
+  if constexpr (N == 0) {
+    return optional_make<T>(fail, i);
+  } else {
+    auto result = optional_layer<T, N - 1>(fail, i);
+    if (!result) {
+      return std::nullopt;
+    }
+    return Payload<T>::step(std::move(*result));
+  }
+}
+
+template <typename T>
+void try_voe(State& state) {
+  Failures const failures(state.error_rate());
+  std::size_t sum = 0U;
+  std::size_t errors = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    auto const result = voe_layer<T, Layers>(failures[i], i);
+    if (result) {
+      sum += Payload<T>::weight(result.value());
+    } else {
+      ++errors;
+    }
+  }
+  report(state, sum, errors);
+}
+
+template <typename T>
+void try_exception(State& state) {
+  Failures const failures(state.error_rate());
+  std::size_t sum = 0U;
+  std::size_t errors = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    try {
+      auto const result = exception_layer<T, Layers>(failures[i], i);
+      sum += Payload<T>::weight(result);
+    } catch (std::system_error const&) {
+      ++errors;
+    }
+  }
+  report(state, sum, errors);
+}
+
+template <typename T>
+void try_code(State& state) {
+  Failures const failures(state.error_rate());
+  std::size_t sum = 0U;
+  std::size_t errors = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    T result{};
+    std::error_code error;
+    code_layer<T, Layers>(failures[i], i, result, error);
+    if (!error) {
+      sum += Payload<T>::weight(result);
+    } else {
+      ++errors;
+    }
+  }
+  report(state, sum, errors);
+}
+
+template <typename T>
+void try_optional(State& state) {
+  Failures const failures(state.error_rate());
+  std::size_t sum = 0U;
+  std::size_t errors = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    auto const result = optional_layer<T, Layers>(failures[i], i);
+    if (result) {
+      sum += Payload<T>::weight(*result);
+    } else {
+      ++errors;
+    }
+  }
+  report(state, sum, errors);
+}
+
+// Destroy: batch of results. An exception leaves nothing behind, so failed
+// entries of exceptions style are default constructed payloads.
+
+template <typename Result, typename Fill>
+void destroy_batch(State& state, Fill fill) {
+  Failures const failures(state.error_rate());
+  std::vector<Result> batch;
+  batch.reserve(BatchSize);
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    state.pause();
+    for (std::size_t j = 0U; j < BatchSize; ++j) {
+      fill(batch, failures[i * BatchSize + j], j);
+    }
+    state.resume();
+    batch.clear();
+    rms::bench::clobber_memory();
+  }
+  state.counter("batch", BatchSize);
+}
+
+template <typename T>
+void destroy_voe(State& state) {
+  destroy_batch<rms::ValueOrError<T>>(
+      state, [](std::vector<rms::ValueOrError<T>>& batch, bool fail,
+                std::size_t i) {
+        if (fail) {
+          batch.emplace_back(failure());
+          batch.back().ignore();
+        } else {
+          batch.emplace_back(Payload<T>::make(i));
+        }
+      });
+}
+
+template <typename T>
+void destroy_exception(State& state) {
+  destroy_batch<T>(state, [](std::vector<T>& batch, bool fail, std::size_t i) {
+    batch.push_back(fail ? T{} : Payload<T>::make(i));
+  });
+}
+
+template <typename T>
+struct CodeResult {
+  T value;
+  std::error_code error;
+};
+
+template <typename T>
+void destroy_code(State& state) {
+  destroy_batch<CodeResult<T>>(
+      state, [](std::vector<CodeResult<T>>& batch, bool fail, std::size_t i) {
+        if (fail) {
+          batch.push_back({T{}, failure()});
+        } else {
+          batch.push_back({Payload<T>::make(i), std::error_code()});
+        }
+      });
+}
+
+template <typename T>
+void destroy_optional(State& state) {
+  destroy_batch<std::optional<T>>(
+      state, [](std::vector<std::optional<T>>& batch, bool fail,
+                std::size_t i) {
+        if (fail) {
+          batch.emplace_back(std::nullopt);
+        } else {
+          batch.emplace_back(Payload<T>::make(i));
+        }
+      });
+}
+
+void add(std::string const& name, rms::bench::BenchmarkFn fn) {
+  rms::bench::registry().push_back({"Compare" + name, std::move(fn), true});
+}
+
+template <typename T>
+void add_payload(std::string const& payload) {
+  add("Construct/ValueOrError/" + payload, construct_voe<T>);
+  add("Construct/Exception/" + payload, construct_exception<T>);
+  add("Construct/ErrorCode/" + payload, construct_code<T>);
+  add("Construct/Optional/" + payload, construct_optional<T>);
+  add("Then/ValueOrError/" + payload, then_voe<T>);
+  add("Then/Exception/" + payload, then_exception<T>);
+  add("Then/ErrorCode/" + payload, then_code<T>);
+  add("Then/Optional/" + payload, then_optional<T>);
+  add("Try/ValueOrError/" + payload, try_voe<T>);
+  add("Try/Exception/" + payload, try_exception<T>);
+  add("Try/ErrorCode/" + payload, try_code<T>);
+  add("Try/Optional/" + payload, try_optional<T>);
+  add("Destroy/ValueOrError/" + payload, destroy_voe<T>);
+  add("Destroy/Exception/" + payload, destroy_exception<T>);
+  add("Destroy/ErrorCode/" + payload, destroy_code<T>);
+  add("Destroy/Optional/" + payload, destroy_optional<T>);
+}
+
+struct Registration {
+  Registration() {
+    add_payload<int>("Int");
+    add_payload<std::string>("String");
+    add_payload<std::vector<std::string>>("VectorOfStrings");
+  }
+};
+
+Registration const registration;
+
+}  // namespace
@@ -0,0 +1,136 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+// Cost of co_await against VOE_TRY_EXTRACT: an int or a std::string result
+// is propagated through three nested calls, each of them a coroutine or a
+// function with the macro. Frame/* compares FramePool with operator new for
+// a frame sized block. Runs once per error rate.
+#include <cstdint>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "bench.h"
+#include "coroutine.h"
+#include "try.h"
+#include "value_or_error.h"
+
+namespace {
+
+using rms::ValueOrError;
+using rms::bench::State;
+
+constexpr std::size_t FrameSize = 96U;
+
+class Source {
+ public:
+  explicit Source(double error_rate)
+      : m_error_threshold(static_cast<std::uint32_t>(error_rate * 10000.0)) {}
+
+  bool fails(std::size_t i) const noexcept {
+    return (i * 2654435761U) % 10000U < m_error_threshold;
+  }
+
+ private:
+  std::uint32_t const m_error_threshold;
+};
+
+template <typename T>
+struct Payload;
+
+template <>
+struct Payload<int> {
+  static int make(std::size_t i) { return static_cast<int>(i & 0xffU); }
+  static int step(int value) { return value + 1; }
+  static std::size_t weight(int value) {
+    return static_cast<std::size_t>(value);
+  }
+};
+
+template <>
+struct Payload<std::string> {
+  static std::string make(std::size_t i) {
+    return std::string(i % 2U == 0U ? "John" : "Steve") +
+           " the customer with a long name";
+  }
+  static std::string step(std::string value) {
+    value.back() = '!';
+    return value;
+  }
+  static std::size_t weight(std::string const& value) { return value.size(); }
+};
+
+template <typename T>
+__attribute__((noinline)) ValueOrError<T> source(bool fail, std::size_t i) {
+  if (fail) {
+    return std::make_error_code(std::errc::timed_out);
+  }
+  return Payload<T>::make(i);
+}
+
+template <typename T, int N>
+__attribute__((noinline)) ValueOrError<T> try_layer(bool fail, std::size_t i) {
+  if constexpr (N == 0) {
+    return source<T>(fail, i);
+  } else {
+    VOE_TRY_EXTRACT(value, try_layer<T, N - 1>(fail, i));
+    return Payload<T>::step(std::move(value));
+  }
+}
+
+template <typename T, int N>
+__attribute__((noinline)) ValueOrError<T> co_layer(bool fail, std::size_t i) {
+  if constexpr (N == 0) {
+    co_return source<T>(fail, i);
+  } else {
+    co_return Payload<T>::step(co_await co_layer<T, N - 1>(fail, i));
+  }
+}
+
+template <typename T, ValueOrError<T> (*Layer)(bool, std::size_t)>
+void propagate(State& state) {
+  Source const errors(state.error_rate());
+  std::size_t sum = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    auto result = Layer(errors.fails(i), i);
+    sum += result ? Payload<T>::weight(result.value()) : 1U;
+  }
+  rms::bench::do_not_optimize(sum);
+}
+
+void frame_pool(State& state) {
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    void* const frame = rms::detail::FramePool::allocate(FrameSize);
+    rms::bench::do_not_optimize(frame);
+    rms::detail::FramePool::deallocate(frame, FrameSize);
+  }
+}
+
+void frame_heap(State& state) {
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    void* const frame = ::operator new(FrameSize);
+    rms::bench::do_not_optimize(frame);
+    ::operator delete(frame);
+  }
+}
+
+void add(std::string const& name, rms::bench::BenchmarkFn fn,
+         bool with_error_rates) {
+  rms::bench::registry().push_back(
+      {"Coroutine" + name, std::move(fn), with_error_rates});
+}
+
+struct Registration {
+  Registration() {
+    add("/Int/Try", propagate<int, try_layer<int, 3>>, true);
+    add("/Int/CoAwait", propagate<int, co_layer<int, 3>>, true);
+    add("/String/Try", propagate<std::string, try_layer<std::string, 3>>,
+        true);
+    add("/String/CoAwait", propagate<std::string, co_layer<std::string, 3>>,
+        true);
+    add("/Frame/Pool", frame_pool, false);
+    add("/Frame/Heap", frame_heap, false);
+  }
+};
+
+Registration const registration;
+
+}  // namespace
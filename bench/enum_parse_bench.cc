@@ -0,0 +1,127 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+// Enum value from its name: operator>> of EnumFromStream (std::string and
+// linear search) against EnumFromChars (binary search of the hashes sorted at
+// compile time). Small enum has 4 names, large one 256 names with a common
+// prefix. Names are taken round robin, one in 16 is unknown.
+#include <array>
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "enum_util.h"
+
+namespace {
+
+using rms::bench::State;
+using rms::util::enum_util::EnumFromChars;
+using rms::util::enum_util::EnumFromStream;
+using rms::util::enum_util::ToIntegral;
+
+#define SMALL_ENUM_LIST(X)      \
+  X(Success, "Success")         \
+  X(Timeout, "Timeout")         \
+  X(Canceled, "Canceled")       \
+  X(Interrupted, "Interrupted")
+
+RMS_ENUM_WITH_STRINGS(SmallEnum, SMALL_ENUM_LIST)
+
+enum class LargeEnum : int {};
+
+constexpr std::size_t LargeEnumSize = 256U;
+constexpr std::size_t NamesCount = 1024U;
+constexpr std::size_t UnknownPeriod = 16U;
+
+struct LargeNames {
+  char names[LargeEnumSize][sizeof("ErrorCode255")];
+};
+
+constexpr LargeNames make_large_names() noexcept {
+  LargeNames result{};
+  for (std::size_t i = 0U; i < LargeEnumSize; ++i) {
+    auto* name = result.names[i];
+    for (auto const* prefix = "ErrorCode"; *prefix != '\0'; ++prefix) {
+      *name++ = *prefix;
+    }
+    std::size_t digits = 1U;
+    for (auto rest = i / 10U; rest != 0U; rest /= 10U) {
+      ++digits;
+    }
+    for (auto rest = i; digits != 0U; rest /= 10U) {
+      name[--digits] = static_cast<char>('0' + rest % 10U);
+    }
+  }
+  return result;
+}
+
+constexpr LargeNames large_names = make_large_names();
+
+template <std::size_t... Indices>
+constexpr std::array<char const*, LargeEnumSize> large_strings(
+    std::index_sequence<Indices...>) noexcept {
+  return {{large_names.names[Indices]...}};
+}
+
+constexpr std::array<char const*, LargeEnumSize> enum_strings(
+    LargeEnum) noexcept {
+  return large_strings(std::make_index_sequence<LargeEnumSize>());
+}
+
+template <typename T>
+std::vector<std::string> make_input() {
+  auto const strings = enum_strings(T());
+  std::vector<std::string> names;
+  names.reserve(NamesCount);
+  for (std::size_t i = 0U; i < NamesCount; ++i) {
+    if (i % UnknownPeriod == 0U) {
+      names.emplace_back("Unknown");
+    } else {
+      names.emplace_back(strings[(i * 7U) % strings.size()]);
+    }
+  }
+  return names;
+}
+
+template <typename T>
+void from_stream(State& state) {
+  auto const names = make_input<T>();
+  int sum = 0;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    std::istringstream stream(names[i % NamesCount]);
+    T value{};
+    stream >> EnumFromStream(value);
+    sum += ToIntegral(value);
+  }
+  rms::bench::do_not_optimize(sum);
+}
+
+template <typename T>
+void from_chars(State& state) {
+  auto const names = make_input<T>();
+  int sum = 0;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    auto const& name = names[i % NamesCount];
+    auto value = EnumFromChars<T>(name.data(), name.size());
+    sum += value ? ToIntegral(value.value()) : -1;
+  }
+  rms::bench::do_not_optimize(sum);
+}
+
+void add(std::string const& name, rms::bench::BenchmarkFn fn) {
+  rms::bench::registry().push_back({"EnumParse" + name, std::move(fn), false});
+}
+
+struct Registration {
+  Registration() {
+    add("/Small/Stream", from_stream<SmallEnum>);
+    add("/Small/FromChars", from_chars<SmallEnum>);
+    add("/Large/Stream", from_stream<LargeEnum>);
+    add("/Large/FromChars", from_chars<LargeEnum>);
+  }
+};
+
+Registration const registration;
+
+}  // namespace
@@ -0,0 +1,100 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+// Logging of a batch of failed results into a stream which drops the output.
+// Message: error().message() std::string is written, as operator<< did.
+// Stream: operator<< of ValueOrError, DBErrorCategory gives static messages.
+// Generic: operator<< with an error of a category without static messages.
+// Messages are longer than the small string buffer of std::string.
+#include <cstddef>
+#include <ostream>
+#include <streambuf>
+#include <system_error>
+#include <vector>
+
+#include "bench.h"
+#include "db_error.h"
+#include "value_or_error.h"
+
+namespace {
+
+using rms::ValueOrError;
+using rms::bench::State;
+
+constexpr std::size_t ResultsCount = 1000000U;
+
+// Counts and drops the characters
+class NullBuffer : public std::streambuf {
+ public:
+  std::size_t written() const noexcept { return m_written; }
+
+ protected:
+  std::streamsize xsputn(char const*, std::streamsize count) override {
+    m_written += static_cast<std::size_t>(count);
+    return count;
+  }
+
+  int_type overflow(int_type ch) override {
+    ++m_written;
+    return traits_type::not_eof(ch);
+  }
+
+ private:
+  std::size_t m_written = 0U;
+};
+
+std::vector<ValueOrError<int>> make_batch(std::error_code error) {
+  std::vector<ValueOrError<int>> batch;
+  batch.reserve(ResultsCount);
+  for (std::size_t i = 0U; i < ResultsCount; ++i) {
+    batch.emplace_back(error);
+  }
+  return batch;
+}
+
+template <typename Log>
+void log_batch(State& state, std::error_code error, Log log) {
+  state.pause();
+  auto const batch = make_batch(error);
+  NullBuffer buffer;
+  std::ostream stream(&buffer);
+  state.resume();
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    for (auto const& result : batch) {
+      log(stream, result);
+    }
+  }
+  rms::bench::do_not_optimize(buffer.written());
+  state.counter("results", static_cast<double>(ResultsCount));
+}
+
+void message(State& state) {
+  log_batch(state, make_error_code(rms::DBError::QueryInterrupted),
+            [](std::ostream& stream, ValueOrError<int> const& result) {
+              stream << result.error().message() << '\n';
+            });
+}
+
+void stream(State& state) {
+  log_batch(state, make_error_code(rms::DBError::QueryInterrupted),
+            [](std::ostream& stream, ValueOrError<int> const& result) {
+              stream << result << '\n';
+            });
+}
+
+void generic(State& state) {
+  log_batch(state, std::make_error_code(std::errc::connection_refused),
+            [](std::ostream& stream, ValueOrError<int> const& result) {
+              stream << result << '\n';
+            });
+}
+
+struct Registration {
+  Registration() {
+    rms::bench::registry().push_back({"ErrorLog/Message", message, false});
+    rms::bench::registry().push_back({"ErrorLog/Stream", stream, false});
+    rms::bench::registry().push_back({"ErrorLog/Generic", generic, false});
+  }
+};
+
+Registration const registration;
+
+}  // namespace
@@ -0,0 +1,124 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+// One step continuation of an int result: rms::Future::then_async() on
+// ThreadPool and on InlineExecutor against std::future<ValueOrError<int>>
+// continued with std::async. The continuation is attached before the result
+// is set (BeforeReady) and after it (AfterReady). Runs once per error rate.
+#include <cstdint>
+#include <future>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "bench.h"
+#include "future.h"
+#include "thread_pool.h"
+#include "value_or_error.h"
+
+namespace {
+
+using rms::ValueOrError;
+using rms::bench::State;
+
+class Source {
+ public:
+  explicit Source(double error_rate)
+      : m_error_threshold(static_cast<std::uint32_t>(error_rate * 10000.0)) {}
+
+  ValueOrError<int> make(std::size_t i) const {
+    if ((i * 2654435761U) % 10000U < m_error_threshold) {
+      return std::make_error_code(std::errc::timed_out);
+    }
+    return static_cast<int>(i & 0xffU);
+  }
+
+ private:
+  std::uint32_t const m_error_threshold;
+};
+
+ValueOrError<int> next_step(int value) { return value + 1; }
+
+std::size_t weight(ValueOrError<int>&& result) {
+  return result ? static_cast<std::size_t>(result.value()) : 1U;
+}
+
+template <typename Executor, bool BeforeReady>
+void voe_future(State& state, Executor& executor) {
+  Source const source(state.error_rate());
+  std::size_t sum = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    rms::Promise<int> promise;
+    auto future = promise.get_future();
+    if (BeforeReady) {
+      auto next = std::move(future).then_async(executor, next_step);
+      promise.set_result(source.make(i));
+      sum += weight(std::move(next).get());
+    } else {
+      promise.set_result(source.make(i));
+      auto next = std::move(future).then_async(executor, next_step);
+      sum += weight(std::move(next).get());
+    }
+  }
+  rms::bench::do_not_optimize(sum);
+}
+
+template <bool BeforeReady>
+void voe_pool(State& state) {
+  state.pause();
+  {
+    rms::ThreadPool pool(1U);
+    state.resume();
+    voe_future<rms::ThreadPool, BeforeReady>(state, pool);
+    state.pause();
+  }
+  state.resume();
+}
+
+template <bool BeforeReady>
+void voe_inline(State& state) {
+  rms::InlineExecutor executor;
+  voe_future<rms::InlineExecutor, BeforeReady>(state, executor);
+}
+
+template <bool BeforeReady>
+void std_future(State& state) {
+  Source const source(state.error_rate());
+  std::size_t sum = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    std::promise<ValueOrError<int>> promise;
+    auto future = promise.get_future();
+    auto const continue_async = [&future] {
+      return std::async(std::launch::async, [&future] {
+        return future.get().then(next_step);
+      });
+    };
+    if (BeforeReady) {
+      auto next = continue_async();
+      promise.set_value(source.make(i));
+      sum += weight(next.get());
+    } else {
+      promise.set_value(source.make(i));
+      auto next = continue_async();
+      sum += weight(next.get());
+    }
+  }
+  rms::bench::do_not_optimize(sum);
+}
+
+void add(std::string const& name, rms::bench::BenchmarkFn fn) {
+  rms::bench::registry().push_back({"Future" + name, std::move(fn), true});
+}
+
+struct Registration {
+  Registration() {
+    add("BeforeReady/Voe/Pool", voe_pool<true>);
+    add("BeforeReady/Voe/Inline", voe_inline<true>);
+    add("BeforeReady/Std/Async", std_future<true>);
+    add("AfterReady/Voe/Pool", voe_pool<false>);
+    add("AfterReady/Voe/Inline", voe_inline<false>);
+    add("AfterReady/Std/Async", std_future<false>);
+  }
+};
+
+Registration const registration;
+
+}  // namespace
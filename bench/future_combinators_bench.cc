@@ -0,0 +1,182 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+// Fan-out latency of independent lookups shaped as BusinessService calls:
+// the customer, their permissions and their orders, each roughly a
+// microsecond of CPU work returning ValueOrError. Serial calls one after
+// another against rms::async() on ThreadPool joined by rms::when_all(), and
+// rms::when_any() of replicated lookups. Wide fans out 16 lookups through the
+// vector overloads. Runs once per error rate.
+#include <cstdint>
+#include <string>
+#include <system_error>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "future.h"
+#include "future_combinators.h"
+#include "thread_pool.h"
+#include "value_or_error.h"
+
+namespace {
+
+using rms::ThreadPool;
+using rms::ValueOrError;
+using rms::bench::State;
+
+constexpr std::size_t WideLookups = 16U;
+
+// Stands for a query, roughly a microsecond of CPU work
+std::uint64_t query(std::uint64_t seed) {
+  for (int i = 0; i < 256; ++i) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    rms::bench::do_not_optimize(seed);
+  }
+  return seed;
+}
+
+class Lookups {
+ public:
+  explicit Lookups(double error_rate)
+      : m_error_threshold(static_cast<std::uint32_t>(error_rate * 10000.0)) {}
+
+  ValueOrError<std::string> customer(std::size_t i) const {
+    auto const seed = query(i);
+    if (failed(i)) {
+      return std::make_error_code(std::errc::timed_out);
+    }
+    return std::string(seed % 2U == 0U ? "John" : "Steve");
+  }
+
+  ValueOrError<bool> permissions(std::size_t i) const {
+    return query(i + 1U) % 2U == 0U;
+  }
+
+  ValueOrError<std::size_t> orders(std::size_t i) const {
+    return static_cast<std::size_t>(query(i + 2U) % 16U);
+  }
+
+ private:
+  bool failed(std::size_t i) const noexcept {
+    return (i * 2654435761U) % 10000U < m_error_threshold;
+  }
+
+  std::uint32_t const m_error_threshold;
+};
+
+std::size_t weight(
+    ValueOrError<std::tuple<std::string, bool, std::size_t>>&& result) {
+  if (!result) {
+    return 1U;
+  }
+  auto const& value = result.value();
+  return std::get<0>(value).size() + std::get<1>(value) + std::get<2>(value);
+}
+
+void serial(State& state) {
+  Lookups const lookups(state.error_rate());
+  std::size_t sum = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    auto customer = lookups.customer(i);
+    if (!customer) {
+      ++sum;
+      continue;
+    }
+    auto permissions = lookups.permissions(i);
+    auto orders = lookups.orders(i);
+    sum += customer.value().size() + permissions.value() + orders.value();
+  }
+  rms::bench::do_not_optimize(sum);
+}
+
+void fan_out(State& state, ThreadPool& pool) {
+  Lookups const lookups(state.error_rate());
+  std::size_t sum = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    auto all = rms::when_all(
+        rms::async(pool, [&lookups, i] { return lookups.customer(i); }),
+        rms::async(pool, [&lookups, i] { return lookups.permissions(i); }),
+        rms::async(pool, [&lookups, i] { return lookups.orders(i); }));
+    sum += weight(std::move(all).get());
+  }
+  rms::bench::do_not_optimize(sum);
+}
+
+// The same lookup sent to three replicas, the first answer wins
+void any_of(State& state, ThreadPool& pool) {
+  Lookups const lookups(state.error_rate());
+  std::size_t sum = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    auto const lookup = [&lookups, i] { return lookups.customer(i); };
+    auto any = rms::when_any(rms::async(pool, lookup),
+                             rms::async(pool, lookup),
+                             rms::async(pool, lookup));
+    auto customer = std::move(any).get();
+    sum += customer ? customer.value().size() : 1U;
+  }
+  rms::bench::do_not_optimize(sum);
+}
+
+void wide_serial(State& state) {
+  Lookups const lookups(state.error_rate());
+  std::size_t sum = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    for (std::size_t j = 0U; j < WideLookups; ++j) {
+      auto customer = lookups.customer(i * WideLookups + j);
+      if (!customer) {
+        ++sum;
+        break;
+      }
+      sum += customer.value().size();
+    }
+  }
+  rms::bench::do_not_optimize(sum);
+}
+
+void wide_fan_out(State& state, ThreadPool& pool) {
+  Lookups const lookups(state.error_rate());
+  std::size_t sum = 0U;
+  std::vector<rms::Future<std::string>> futures;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    futures.clear();
+    for (std::size_t j = 0U; j < WideLookups; ++j) {
+      auto const index = i * WideLookups + j;
+      futures.push_back(rms::async(
+          pool, [&lookups, index] { return lookups.customer(index); }));
+    }
+    auto customers = rms::when_all(std::move(futures)).get();
+    sum += customers ? customers.value().size() : 1U;
+  }
+  rms::bench::do_not_optimize(sum);
+}
+
+template <void (*Fn)(State&, ThreadPool&)>
+void on_pool(State& state) {
+  state.pause();
+  {
+    ThreadPool pool;
+    state.resume();
+    Fn(state, pool);
+    state.pause();
+  }
+  // Joining of the threads is not measured
+  state.resume();
+}
+
+void add(std::string const& name, rms::bench::BenchmarkFn fn) {
+  rms::bench::registry().push_back({"FanOut" + name, std::move(fn), true});
+}
+
+struct Registration {
+  Registration() {
+    add("/Serial", serial);
+    add("/WhenAll", on_pool<fan_out>);
+    add("/WhenAny", on_pool<any_of>);
+    add("Wide/Serial", wide_serial);
+    add("Wide/WhenAll", on_pool<wide_fan_out>);
+  }
+};
+
+Registration const registration;
+
+}  // namespace
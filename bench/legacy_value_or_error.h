@@ -0,0 +1,79 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#pragma once
+
+/*
+ * Former layout of ValueOrError: boost::variant plus three bools.
+ * Kept only as a baseline for benchmarks.
+ */
+
+#include <boost/variant.hpp>
+#include <cstdlib>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+namespace rms {
+namespace bench {
+namespace legacy {
+
+template <typename T>
+class ValueOrError {
+ public:
+  using value_type = T;
+  using storage_type =
+      boost::variant<boost::blank, std::error_code, value_type>;
+
+  // cppcheck-suppress noExplicitConstructor
+  ValueOrError(std::error_code error_code)  // NOLINT
+      : m_has_error(true), m_storage(error_code) {}
+
+  // cppcheck-suppress noExplicitConstructor
+  ValueOrError(value_type value)  // NOLINT
+      : m_has_error(false), m_storage(std::move(value)), m_empty_value(false) {}
+
+  ValueOrError(ValueOrError&& other) {
+    m_storage = std::move(other.m_storage);
+    m_has_error = other.m_has_error;
+    m_handled = other.m_handled;
+    m_empty_value = other.m_empty_value;
+    other.m_handled = true;
+    other.m_empty_value = true;
+  }
+
+  ~ValueOrError() {
+    if (m_has_error) {
+      if (!m_handled) {
+        std::abort();
+      }
+    }
+  }
+
+  explicit operator bool() const noexcept {
+    return m_handled = true, !m_has_error;
+  }
+
+  std::error_code error() const {
+    m_handled = true;
+    return m_has_error ? boost::get<std::error_code>(m_storage)
+                       : std::error_code();
+  }
+
+  bool has_value() const noexcept { return !m_has_error && !m_empty_value; }
+
+  value_type& value() {
+    if (!has_value()) {
+      throw std::logic_error("Value is not stored.");
+    }
+    return boost::get<value_type>(m_storage);
+  }
+
+ private:
+  mutable bool m_handled = false;
+  bool m_has_error;
+  storage_type m_storage;
+  bool m_empty_value = true;
+};
+
+}  // namespace legacy
+}  // namespace bench
+}  // namespace rms
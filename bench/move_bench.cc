@@ -0,0 +1,77 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+// Growth of a vector of results. Moves of ValueOrError are noexcept, so
+// reallocation must move payloads instead of copying them.
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "value_or_error.h"
+
+namespace {
+
+constexpr std::size_t ResultsCount = 1000000U;
+
+class Payload {
+ public:
+  explicit Payload(std::string data) : m_data(std::move(data)) {}
+
+  Payload(Payload const& other) : m_data(other.m_data) { ++Copies; }
+
+  Payload(Payload&& other) noexcept : m_data(std::move(other.m_data)) {
+    ++Moves;
+  }
+
+  Payload& operator=(Payload const& other) {
+    m_data = other.m_data;
+    ++Copies;
+    return *this;
+  }
+
+  Payload& operator=(Payload&& other) noexcept {
+    m_data = std::move(other.m_data);
+    ++Moves;
+    return *this;
+  }
+
+  ~Payload() = default;
+
+  std::string const& data() const { return m_data; }
+
+  static std::size_t Copies;
+  static std::size_t Moves;
+
+ private:
+  std::string m_data;
+};
+
+std::size_t Payload::Copies = 0U;
+std::size_t Payload::Moves = 0U;
+
+}  // namespace
+
+VOE_BENCHMARK(MoveGrowVectorOfResults) {
+  Payload::Copies = 0U;
+  Payload::Moves = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    std::vector<rms::ValueOrError<Payload>> results;
+    for (std::size_t j = 0U; j < ResultsCount; ++j) {
+      results.emplace_back(Payload("customer"));
+    }
+    rms::bench::do_not_optimize(results.data());
+  }
+  state.counter("copies", static_cast<double>(Payload::Copies));
+  state.counter("moves_per_result",
+                static_cast<double>(Payload::Moves) /
+                    static_cast<double>(state.iterations() * ResultsCount));
+}
+
+VOE_BENCHMARK(MoveGrowVectorOfStrings) {
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    std::vector<rms::ValueOrError<std::string>> results;
+    for (std::size_t j = 0U; j < ResultsCount; ++j) {
+      results.emplace_back(std::string("customer"));
+    }
+    rms::bench::do_not_optimize(results.data());
+  }
+}
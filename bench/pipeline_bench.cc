@@ -0,0 +1,112 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+// Five stage chain built eagerly with then() (every stage materializes
+// ValueOrError) and as a lazy pipeline (only the final result is
+// materialized). Payloads are int and std::string.
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "bench.h"
+#include "pipeline.h"
+#include "value_or_error.h"
+
+namespace {
+
+using rms::ValueOrError;
+
+template <typename T>
+struct Stages;
+
+template <>
+struct Stages<int> {
+  static int make(std::size_t i) { return static_cast<int>(i & 0xffU); }
+  static ValueOrError<int> check(int value) {
+    if (value < 0) {
+      return std::make_error_code(std::errc::invalid_argument);
+    }
+    return value;
+  }
+  static int transform(int value) { return value + 1; }
+  static std::size_t weight(int value) {
+    return static_cast<std::size_t>(value);
+  }
+};
+
+template <>
+struct Stages<std::string> {
+  static std::string make(std::size_t) {
+    return "customer name which is long enough";
+  }
+  static ValueOrError<std::string> check(std::string&& value) {
+    if (value.empty()) {
+      return std::make_error_code(std::errc::invalid_argument);
+    }
+    return std::move(value);
+  }
+  static std::string transform(std::string&& value) {
+    value.back() = '!';
+    return std::move(value);
+  }
+  static std::size_t weight(std::string const& value) { return value.size(); }
+};
+
+template <typename T>
+__attribute__((noinline)) ValueOrError<T> source(std::size_t i) {
+  return Stages<T>::make(i);
+}
+
+// check | transform | check | transform | transform
+template <typename T>
+__attribute__((noinline)) ValueOrError<T> eager(std::size_t i) {
+  auto const check = [](T& value) {
+    return Stages<T>::check(std::move(value));
+  };
+  auto const transform = [](T& value) {
+    return ValueOrError<T>(Stages<T>::transform(std::move(value)));
+  };
+  return source<T>(i)
+      .then(check)
+      .then(transform)
+      .then(check)
+      .then(transform)
+      .then(transform);
+}
+
+template <typename T>
+__attribute__((noinline)) ValueOrError<T> lazy(std::size_t i) {
+  using rms::pipeline::map;
+  using rms::pipeline::pipe;
+  using rms::pipeline::then;
+  auto const check = [](T&& value) {
+    return Stages<T>::check(std::move(value));
+  };
+  auto const transform = [](T&& value) {
+    return Stages<T>::transform(std::move(value));
+  };
+  return (pipe(source<T>(i)) | then(check) | map(transform) | then(check) |
+          map(transform) | map(transform))
+      .run();
+}
+
+template <typename T, ValueOrError<T> (*Chain)(std::size_t)>
+void run(rms::bench::State& state) {
+  std::size_t sum = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    auto const result = Chain(i);
+    if (result) {
+      sum += Stages<T>::weight(result.value());
+    }
+  }
+  rms::bench::do_not_optimize(sum);
+}
+
+}  // namespace
+
+VOE_BENCHMARK(PipelineEagerInt) { run<int, eager<int>>(state); }
+VOE_BENCHMARK(PipelineLazyInt) { run<int, lazy<int>>(state); }
+VOE_BENCHMARK(PipelineEagerString) {
+  run<std::string, eager<std::string>>(state);
+}
+VOE_BENCHMARK(PipelineLazyString) {
+  run<std::string, lazy<std::string>>(state);
+}
@@ -0,0 +1,71 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+// Compares compact storage of ValueOrError with the former
+// boost::variant based layout.
+#include <system_error>
+#include <vector>
+
+#include "bench.h"
+#include "legacy_value_or_error.h"
+#include "value_or_error.h"
+
+namespace {
+
+using Current = rms::ValueOrError<int>;
+using Legacy = rms::bench::legacy::ValueOrError<int>;
+
+constexpr std::size_t BatchSize = 1024U;
+
+template <typename Result>
+__attribute__((noinline)) Result make_result(int value) {
+  if (value < 0) {
+    return std::make_error_code(std::errc::invalid_argument);
+  }
+  return value;
+}
+
+template <typename Result>
+void return_value(rms::bench::State& state) {
+  int sum = 0;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    auto result = make_result<Result>(static_cast<int>(i & 0xffU));
+    if (result) {
+      sum += result.value();
+    }
+  }
+  rms::bench::do_not_optimize(sum);
+  state.counter("bytes", sizeof(Result));
+}
+
+template <typename Result>
+void return_error(rms::bench::State& state) {
+  int sum = 0;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    auto result = make_result<Result>(-1);
+    sum += result.error().value();
+  }
+  rms::bench::do_not_optimize(sum);
+}
+
+template <typename Result>
+void fill_batch(rms::bench::State& state) {
+  std::vector<Result> batch;
+  batch.reserve(BatchSize);
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    batch.clear();
+    for (std::size_t j = 0U; j < BatchSize; ++j) {
+      batch.emplace_back(static_cast<int>(j));
+    }
+    rms::bench::do_not_optimize(batch.data());
+    rms::bench::clobber_memory();
+  }
+  state.counter("batch_bytes", sizeof(Result) * BatchSize);
+}
+
+}  // namespace
+
+VOE_BENCHMARK(StorageReturnValue) { return_value<Current>(state); }
+VOE_BENCHMARK(StorageReturnValueLegacy) { return_value<Legacy>(state); }
+VOE_BENCHMARK(StorageReturnError) { return_error<Current>(state); }
+VOE_BENCHMARK(StorageReturnErrorLegacy) { return_error<Legacy>(state); }
+VOE_BENCHMARK(StorageFillBatch) { fill_batch<Current>(state); }
+VOE_BENCHMARK(StorageFillBatchLegacy) { fill_batch<Legacy>(state); }
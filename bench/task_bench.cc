@@ -0,0 +1,302 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+// BusinessService::is_current_customer_auth() -> DBManager call chain
+// rewritten with rms::Task. Every DB call is an I/O request which completes
+// after a fixed latency.
+// Io/Blocking: each request runs on ThreadPool as plain functions which
+// sleep for the latency, so a worker is blocked for the whole chain.
+// Io/Task: each request is a Task which suspends for the latency, a timer
+// thread resumes it on the same ThreadPool. Both run a burst of requests
+// per iteration on two threads.
+// Chain/*: the same chain without I/O, plain functions against Tasks, i.e.
+// the cost of the frames and of the transfers. Runs once per error rate.
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "future.h"
+#include "task.h"
+#include "thread_pool.h"
+#include "value_or_error.h"
+
+namespace {
+
+using rms::Task;
+using rms::ThreadPool;
+using rms::ValueOrError;
+using rms::bench::State;
+
+constexpr std::size_t Requests = 256U;
+constexpr std::size_t Threads = 2U;
+constexpr std::chrono::microseconds Latency(50);
+
+// Completes I/O requests after Latency: resumes the awaiting coroutine on
+// the pool from a timer thread
+class SimulatedIo {
+ public:
+  class Awaiter {
+   public:
+    explicit Awaiter(SimulatedIo& io) noexcept : m_io(io) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) { m_io.submit(handle); }
+
+    void await_resume() const noexcept {}
+
+   private:
+    SimulatedIo& m_io;
+  };
+
+  explicit SimulatedIo(ThreadPool& pool)
+      : m_pool(pool), m_timer([this] { run(); }) {}
+
+  SimulatedIo(SimulatedIo const&) = delete;
+  SimulatedIo& operator=(SimulatedIo const&) = delete;
+
+  ~SimulatedIo() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_condition.notify_one();
+    m_timer.join();
+  }
+
+  Awaiter request() noexcept { return Awaiter(*this); }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Pending {
+    Clock::time_point deadline;
+    std::coroutine_handle<> handle;
+  };
+
+  void submit(std::coroutine_handle<> handle) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      // The latency is the same for all, so the queue is sorted
+      m_pending.push_back({Clock::now() + Latency, handle});
+    }
+    m_condition.notify_one();
+  }
+
+  void run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop) {
+      if (m_pending.empty()) {
+        m_condition.wait(lock);
+        continue;
+      }
+      auto const deadline = m_pending.front().deadline;
+      if (Clock::now() < deadline) {
+        m_condition.wait_until(lock, deadline);
+        continue;
+      }
+      auto const handle = m_pending.front().handle;
+      m_pending.pop_front();
+      m_pool.post([handle] { handle.resume(); });
+    }
+  }
+
+  ThreadPool& m_pool;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::deque<Pending> m_pending;
+  bool m_stop = false;
+  std::thread m_timer;
+};
+
+class Failures {
+ public:
+  explicit Failures(double error_rate)
+      : m_error_threshold(static_cast<std::uint32_t>(error_rate * 10000.0)) {}
+
+  bool fails(std::size_t i) const noexcept {
+    return (i * 2654435761U) % 10000U < m_error_threshold;
+  }
+
+ private:
+  std::uint32_t const m_error_threshold;
+};
+
+// DBManager and BusinessService as plain functions
+
+class BlockingDb {
+ public:
+  explicit BlockingDb(Failures failures, bool with_io)
+      : m_failures(failures), m_with_io(with_io) {}
+
+  ValueOrError<std::string> get_active_customer(std::size_t i) const {
+    io();
+    if (m_failures.fails(i)) {
+      return std::make_error_code(std::errc::timed_out);
+    }
+    return std::string(i % 2U == 0U ? "John" : "Steve");
+  }
+
+  ValueOrError<bool> is_auth(std::string const& customer) const {
+    io();
+    return customer == "John";
+  }
+
+ private:
+  void io() const {
+    if (m_with_io) {
+      std::this_thread::sleep_for(Latency);
+    }
+  }
+
+  Failures const m_failures;
+  bool const m_with_io;
+};
+
+__attribute__((noinline)) ValueOrError<bool> is_current_customer_auth(
+    BlockingDb const& db, std::size_t i) {
+  return db.get_active_customer(i).then(
+      [&db](std::string const& customer) { return db.is_auth(customer); });
+}
+
+// DBManager and BusinessService as Tasks
+
+class TaskDb {
+ public:
+  TaskDb(Failures failures, SimulatedIo* io) : m_failures(failures), m_io(io) {}
+
+  Task<std::string> get_active_customer(std::size_t i) const {
+    if (m_io != nullptr) {
+      co_await m_io->request();
+    }
+    if (m_failures.fails(i)) {
+      co_return std::make_error_code(std::errc::timed_out);
+    }
+    co_return std::string(i % 2U == 0U ? "John" : "Steve");
+  }
+
+  Task<bool> is_auth(std::string customer) const {
+    if (m_io != nullptr) {
+      co_await m_io->request();
+    }
+    co_return customer == "John";
+  }
+
+ private:
+  Failures const m_failures;
+  SimulatedIo* const m_io;
+};
+
+Task<bool> is_current_customer_auth(TaskDb const& db, std::size_t i) {
+  auto customer = co_await db.get_active_customer(i);
+  co_return co_await db.is_auth(std::move(customer));
+}
+
+Task<bool> on_pool(ThreadPool& pool, TaskDb const& db, std::size_t i) {
+  co_await rms::schedule(pool);
+  co_return co_await is_current_customer_auth(db, i);
+}
+
+std::size_t weight(ValueOrError<bool>&& auth) {
+  return auth ? static_cast<std::size_t>(auth.value()) : 2U;
+}
+
+void io_blocking(State& state) {
+  state.pause();
+  state.counter("requests", static_cast<double>(Requests));
+  {
+    ThreadPool pool(Threads);
+    BlockingDb const db(Failures(state.error_rate()), true);
+    std::atomic<std::size_t> pending{0U};
+    std::atomic<std::size_t> sum{0U};
+    state.resume();
+    for (std::size_t iteration = 0U; iteration < state.iterations();
+         ++iteration) {
+      pending.store(Requests, std::memory_order_relaxed);
+      for (std::size_t i = 0U; i < Requests; ++i) {
+        pool.post([&db, &pending, &sum, i] {
+          sum.fetch_add(weight(is_current_customer_auth(db, i)),
+                        std::memory_order_relaxed);
+          pending.fetch_sub(1U, std::memory_order_release);
+        });
+      }
+      while (pending.load(std::memory_order_acquire) != 0U) {
+        std::this_thread::yield();
+      }
+    }
+    rms::bench::do_not_optimize(sum.load());
+    state.pause();
+  }
+  // Joining of the threads is not measured
+  state.resume();
+}
+
+void io_task(State& state) {
+  state.pause();
+  state.counter("requests", static_cast<double>(Requests));
+  {
+    ThreadPool pool(Threads);
+    SimulatedIo io(pool);
+    TaskDb const db(Failures(state.error_rate()), &io);
+    std::vector<rms::Future<bool>> futures;
+    futures.reserve(Requests);
+    std::size_t sum = 0U;
+    state.resume();
+    for (std::size_t iteration = 0U; iteration < state.iterations();
+         ++iteration) {
+      for (std::size_t i = 0U; i < Requests; ++i) {
+        futures.push_back(rms::start(on_pool(pool, db, i)));
+      }
+      for (auto& future : futures) {
+        sum += weight(std::move(future).get());
+      }
+      futures.clear();
+    }
+    rms::bench::do_not_optimize(sum);
+    state.pause();
+  }
+  state.resume();
+}
+
+void chain_plain(State& state) {
+  BlockingDb const db(Failures(state.error_rate()), false);
+  std::size_t sum = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    sum += weight(is_current_customer_auth(db, i));
+  }
+  rms::bench::do_not_optimize(sum);
+}
+
+void chain_task(State& state) {
+  TaskDb const db(Failures(state.error_rate()), nullptr);
+  std::size_t sum = 0U;
+  for (std::size_t i = 0U; i < state.iterations(); ++i) {
+    sum += weight(rms::start(is_current_customer_auth(db, i)).get());
+  }
+  rms::bench::do_not_optimize(sum);
+}
+
+void add(std::string const& name, rms::bench::BenchmarkFn fn) {
+  rms::bench::registry().push_back({"Task" + name, std::move(fn), true});
+}
+
+struct Registration {
+  Registration() {
+    add("/Io/Blocking", io_blocking);
+    add("/Io/Task", io_task);
+    add("/Chain/Plain", chain_plain);
+    add("/Chain/Task", chain_task);
+  }
+};
+
+Registration const registration;
+
+}  // namespace
@@ -0,0 +1,126 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+// Scalability of ThreadPool from 1 to N threads. Every iteration runs a burst
+// of requests shaped as DBManager -> BusinessService calls: a lookup of the
+// active customer returns ValueOrError<std::string>, its handler posts the
+// auth check which returns ValueOrError<bool>. Failed lookups skip the check.
+// Runs once per error rate.
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include "bench.h"
+#include "thread_pool.h"
+#include "value_or_error.h"
+
+namespace {
+
+using rms::ThreadPool;
+using rms::ValueOrError;
+using rms::bench::State;
+
+constexpr std::size_t Requests = 4096U;
+
+// Stands for a query, roughly a microsecond of CPU work
+std::uint64_t query(std::uint64_t seed) {
+  for (int i = 0; i < 256; ++i) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    rms::bench::do_not_optimize(seed);
+  }
+  return seed;
+}
+
+class Workload {
+ public:
+  Workload(ThreadPool& pool, double error_rate)
+      : m_pool(pool),
+        m_error_threshold(static_cast<std::uint32_t>(error_rate * 10000.0)) {}
+
+  void run() {
+    m_pending.store(Requests, std::memory_order_relaxed);
+    for (std::size_t i = 0U; i < Requests; ++i) {
+      m_pool.post([this, i] { return get_active_customer(i); },
+                  [this](ValueOrError<std::string>&& customer) {
+                    on_customer(std::move(customer));
+                  });
+    }
+    while (m_pending.load(std::memory_order_acquire) != 0U) {
+      std::this_thread::yield();
+    }
+  }
+
+  std::size_t authorized() const noexcept { return m_authorized.load(); }
+
+ private:
+  ValueOrError<std::string> get_active_customer(std::size_t i) const {
+    auto const seed = query(i);
+    if ((i * 2654435761U) % 10000U < m_error_threshold) {
+      return std::make_error_code(std::errc::timed_out);
+    }
+    return std::string(seed % 2U == 0U ? "John" : "Steve");
+  }
+
+  static ValueOrError<bool> is_auth(std::string const& customer) {
+    return query(customer.size()) != 0U && customer == "John";
+  }
+
+  void on_customer(ValueOrError<std::string>&& customer) {
+    if (!customer) {
+      done();
+      return;
+    }
+    m_pool.post(
+        [this, customer = customer.extract()] { return is_auth(customer); },
+        [this](ValueOrError<bool>&& auth) {
+          if (auth && auth.value()) {
+            m_authorized.fetch_add(1U, std::memory_order_relaxed);
+          }
+          done();
+        });
+  }
+
+  void done() { m_pending.fetch_sub(1U, std::memory_order_release); }
+
+  ThreadPool& m_pool;
+  std::uint32_t const m_error_threshold;
+  std::atomic<std::size_t> m_pending{0U};
+  std::atomic<std::size_t> m_authorized{0U};
+};
+
+void scaling(State& state, std::size_t threads) {
+  state.pause();
+  state.counter("requests", static_cast<double>(Requests));
+  {
+    ThreadPool pool(threads);
+    Workload workload(pool, state.error_rate());
+    state.resume();
+    for (std::size_t i = 0U; i < state.iterations(); ++i) {
+      workload.run();
+    }
+    rms::bench::do_not_optimize(workload.authorized());
+    state.pause();
+  }
+  // Joining of the threads is not measured
+  state.resume();
+}
+
+struct Registration {
+  Registration() {
+    auto const cores = ThreadPool::default_concurrency();
+    for (std::size_t threads = 1U;; threads = std::min(threads * 2U, cores)) {
+      rms::bench::registry().push_back(
+          {"ThreadPoolScaling/Threads:" + std::to_string(threads),
+           [threads](State& state) { scaling(state, threads); }, true});
+      if (threads == cores) {
+        break;
+      }
+    }
+  }
+};
+
+Registration const registration;
+
+}  // namespace
@@ -0,0 +1,506 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#pragma once
+
+/*
+ * Partition of ValueOrErrorBatch by its success bitmask:
+ *
+ * - count_errors(batch): number of failures counted over the bitmask;
+ * - compact_values(batch, out): values of successes in order of indices;
+ * - error_indices(batch, out): indices of failures in ascending order.
+ *
+ * Kernels are implemented for AVX2, SSE4.2 and plain C++. The best one
+ * supported by the CPU is selected at runtime with CPUID, so the code is
+ * built for the baseline target. Vector kernels of compact_values() handle
+ * T of 4 bytes (and 8 bytes with AVX2), other sizes use the scalar kernel
+ * with the fast path for fully successful words.
+ *
+ * Output buffers are written through pointers and must have room for all
+ * results: value_count() elements for compact_values(), error_count() for
+ * error_indices(). Indices are 32 bit, so the batch must be smaller than
+ * 2^32 elements.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "config.h"
+#include "value_or_error_batch.h"
+
+#if defined(__x86_64__)
+#define VOE_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define VOE_X86_SIMD 0
+#endif
+
+namespace rms {
+
+enum class SimdLevel { Scalar, Sse42, Avx2 };
+
+namespace detail {
+namespace simd {
+
+constexpr BatchWord FullWord = ~BatchWord(0U);
+
+inline std::size_t full_words(std::size_t size) noexcept {
+  return size / BatchWordBits;
+}
+
+// Bits of the last word which belong to the batch
+inline BatchWord tail_bits(std::size_t size) noexcept {
+  auto const bits = size % BatchWordBits;
+  return bits == 0U ? FullWord : (BatchWord(1U) << bits) - 1U;
+}
+
+// Scalar kernels. They also finish the tail after vector kernels.
+
+inline std::size_t count_values_scalar(BatchWord const* mask,
+                                       std::size_t words) noexcept {
+  std::size_t count = 0U;
+  for (std::size_t i = 0U; i < words; ++i) {
+    count += static_cast<std::size_t>(__builtin_popcountll(mask[i]));
+  }
+  return count;
+}
+
+template <typename T>
+T* compact_values_scalar(T const* values, BatchWord const* mask,
+                         std::size_t first_word, std::size_t words, T* out) {
+  for (std::size_t i = first_word; i < words; ++i) {
+    auto word = mask[i];
+    auto const* group = values + i * BatchWordBits;
+    if (word == FullWord) {
+      std::memcpy(static_cast<void*>(out), group, sizeof(T) * BatchWordBits);
+      out += BatchWordBits;
+      continue;
+    }
+    for (; word != 0U; word &= word - 1U) {
+      *out++ = group[lowest_bit(word)];
+    }
+  }
+  return out;
+}
+
+inline std::uint32_t* error_indices_scalar(BatchWord const* mask,
+                                           std::size_t first_word,
+                                           std::size_t words, BatchWord tail,
+                                           std::uint32_t* out) noexcept {
+  for (std::size_t i = first_word; i < words; ++i) {
+    auto word = ~mask[i] & (i + 1U == words ? tail : FullWord);
+    auto const base = static_cast<std::uint32_t>(i * BatchWordBits);
+    for (; word != 0U; word &= word - 1U) {
+      *out++ = base + static_cast<std::uint32_t>(lowest_bit(word));
+    }
+  }
+  return out;
+}
+
+// Positions of set bits of every byte (or nibble), first ones are valid
+struct Tables {
+  Tables() noexcept {
+    for (unsigned bits = 0U; bits < 256U; ++bits) {
+      unsigned count = 0U;
+      for (unsigned bit = 0U; bit < 8U; ++bit) {
+        if ((bits >> bit) & 1U) {
+          byte_positions[bits][count] = static_cast<std::uint8_t>(bit);
+          lanes32[bits][count] = bit;
+          ++count;
+        }
+      }
+    }
+    for (unsigned bits = 0U; bits < 16U; ++bits) {
+      unsigned count = 0U;
+      for (unsigned bit = 0U; bit < 4U; ++bit) {
+        if ((bits >> bit) & 1U) {
+          lanes64[bits][2U * count] = 2U * bit;
+          lanes64[bits][2U * count + 1U] = 2U * bit + 1U;
+          for (unsigned byte = 0U; byte < 4U; ++byte) {
+            shuffle32[bits][4U * count + byte] =
+                static_cast<std::uint8_t>(4U * bit + byte);
+          }
+          ++count;
+        }
+      }
+    }
+  }
+
+  // Bit positions of a byte, for error indices
+  alignas(8) std::uint8_t byte_positions[256][8] = {};
+  // vpermd control to pack 32 bit lanes selected by a byte
+  alignas(32) std::uint32_t lanes32[256][8] = {};
+  // vpermd control to pack 64 bit lanes selected by a nibble
+  alignas(32) std::uint32_t lanes64[16][8] = {};
+  // pshufb control to pack 32 bit lanes selected by a nibble
+  alignas(16) std::uint8_t shuffle32[16][16] = {};
+};
+
+inline Tables const& tables() {
+  static Tables const instance;
+  return instance;
+}
+
+#if VOE_X86_SIMD
+
+inline SimdLevel detect_level() noexcept {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+    return SimdLevel::Avx2;
+  }
+  if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) {
+    return SimdLevel::Sse42;
+  }
+  return SimdLevel::Scalar;
+}
+
+__attribute__((target("sse4.2,popcnt"))) inline std::size_t
+count_values_sse42(BatchWord const* mask, std::size_t words) noexcept {
+  std::size_t count = 0U;
+  for (std::size_t i = 0U; i < words; ++i) {
+    count += static_cast<std::size_t>(_mm_popcnt_u64(mask[i]));
+  }
+  return count;
+}
+
+// Nibble lookup popcount (W. Mula), four words per iteration
+__attribute__((target("avx2,popcnt"))) inline std::size_t count_values_avx2(
+    BatchWord const* mask, std::size_t words) noexcept {
+  auto const lookup =
+      _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1,
+                       2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  auto const low = _mm256_set1_epi8(0x0f);
+  auto total = _mm256_setzero_si256();
+  std::size_t i = 0U;
+  for (; i + 4U <= words; i += 4U) {
+    auto const v =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(mask + i));
+    auto const lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low));
+    auto const hi = _mm256_shuffle_epi8(
+        lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+    auto const bytes = _mm256_add_epi8(lo, hi);
+    total = _mm256_add_epi64(total,
+                             _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+  }
+  auto count = static_cast<std::size_t>(
+      _mm256_extract_epi64(total, 0) + _mm256_extract_epi64(total, 1) +
+      _mm256_extract_epi64(total, 2) + _mm256_extract_epi64(total, 3));
+  for (; i < words; ++i) {
+    count += static_cast<std::size_t>(_mm_popcnt_u64(mask[i]));
+  }
+  return count;
+}
+
+// Vector kernels process full words, fully successful words are copied as
+// is. Other words are split into groups of lanes. Every group is packed and
+// stored whole at the position given by popcount of the bits before it, so
+// groups don't depend on each other and there are no branches per group.
+// Garbage lanes after the packed ones are overwritten by the next group.
+// Words are processed only while out has room for all lanes of the word, the
+// rest is left to the scalar kernel. Returns the number of processed words.
+
+// Words with at most this many failures are walked by error_indices kernels
+// bit by bit, which is faster than storing every group
+constexpr int SparseWordBits = 4;
+
+__attribute__((target("popcnt"))) inline std::size_t bits_before(
+    BatchWord word, unsigned first) noexcept {
+  return static_cast<std::size_t>(
+      _mm_popcnt_u64(word & ((BatchWord(1U) << first) - 1U)));
+}
+
+// 4 lanes of 32 bits per group
+__attribute__((target("sse4.2,popcnt"))) inline std::size_t
+compact32_sse42(char const* values, BatchWord const* mask, std::size_t words,
+                char*& out, char const* out_end) {
+  auto const& t = tables();
+  auto* cursor = out;
+  std::size_t i = 0U;
+  for (; i < words && out_end - cursor >= 64 * 4; ++i) {
+    auto const word = mask[i];
+    auto const* group = values + i * BatchWordBits * 4U;
+    if (word == FullWord) {
+      std::memcpy(cursor, group, BatchWordBits * 4U);
+      cursor += BatchWordBits * 4U;
+      continue;
+    }
+    for (unsigned first = 0U; word != 0U && first < BatchWordBits;
+         first += 4U) {
+      auto const bits = static_cast<unsigned>((word >> first) & 0xfU);
+      auto const v = _mm_loadu_si128(
+          reinterpret_cast<__m128i const*>(group + first * 4U));
+      auto const control =
+          _mm_load_si128(reinterpret_cast<__m128i const*>(t.shuffle32[bits]));
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i*>(cursor + 4U * bits_before(word, first)),
+          _mm_shuffle_epi8(v, control));
+    }
+    cursor += 4 * _mm_popcnt_u64(word);
+  }
+  out = cursor;
+  return i;
+}
+
+// 8 lanes of 32 bits per group
+__attribute__((target("avx2,popcnt"))) inline std::size_t compact32_avx2(
+    char const* values, BatchWord const* mask, std::size_t words, char*& out,
+    char const* out_end) {
+  auto const& t = tables();
+  auto* cursor = out;
+  std::size_t i = 0U;
+  for (; i < words && out_end - cursor >= 64 * 4; ++i) {
+    auto const word = mask[i];
+    auto const* group = values + i * BatchWordBits * 4U;
+    if (word == FullWord) {
+      std::memcpy(cursor, group, BatchWordBits * 4U);
+      cursor += BatchWordBits * 4U;
+      continue;
+    }
+    for (unsigned first = 0U; word != 0U && first < BatchWordBits;
+         first += 8U) {
+      auto const bits = static_cast<unsigned>((word >> first) & 0xffU);
+      auto const v = _mm256_loadu_si256(
+          reinterpret_cast<__m256i const*>(group + first * 4U));
+      auto const control =
+          _mm256_load_si256(reinterpret_cast<__m256i const*>(t.lanes32[bits]));
+      _mm256_storeu_si256(
+          reinterpret_cast<__m256i*>(cursor + 4U * bits_before(word, first)),
+          _mm256_permutevar8x32_epi32(v, control));
+    }
+    cursor += 4 * _mm_popcnt_u64(word);
+  }
+  out = cursor;
+  return i;
+}
+
+// 4 lanes of 64 bits per group
+__attribute__((target("avx2,popcnt"))) inline std::size_t compact64_avx2(
+    char const* values, BatchWord const* mask, std::size_t words, char*& out,
+    char const* out_end) {
+  auto const& t = tables();
+  auto* cursor = out;
+  std::size_t i = 0U;
+  for (; i < words && out_end - cursor >= 64 * 8; ++i) {
+    auto const word = mask[i];
+    auto const* group = values + i * BatchWordBits * 8U;
+    if (word == FullWord) {
+      std::memcpy(cursor, group, BatchWordBits * 8U);
+      cursor += BatchWordBits * 8U;
+      continue;
+    }
+    for (unsigned first = 0U; word != 0U && first < BatchWordBits;
+         first += 4U) {
+      auto const bits = static_cast<unsigned>((word >> first) & 0xfU);
+      auto const v = _mm256_loadu_si256(
+          reinterpret_cast<__m256i const*>(group + first * 8U));
+      auto const control =
+          _mm256_load_si256(reinterpret_cast<__m256i const*>(t.lanes64[bits]));
+      _mm256_storeu_si256(
+          reinterpret_cast<__m256i*>(cursor + 8U * bits_before(word, first)),
+          _mm256_permutevar8x32_epi32(v, control));
+    }
+    cursor += 8 * _mm_popcnt_u64(word);
+  }
+  out = cursor;
+  return i;
+}
+
+// Bit positions of 4 bits per group
+__attribute__((target("sse4.2,popcnt"))) inline std::size_t
+error_indices_sse42(BatchWord const* mask, std::size_t words,
+                    std::uint32_t*& out, std::uint32_t const* out_end) {
+  auto const& t = tables();
+  auto* cursor = out;
+  std::size_t i = 0U;
+  for (; i < words && out_end - cursor >= 64; ++i) {
+    auto const word = ~mask[i];
+    if (_mm_popcnt_u64(word) <= SparseWordBits) {
+      // few failures are cheaper to walk bit by bit
+      auto const base = static_cast<std::uint32_t>(i * BatchWordBits);
+      for (auto bits = word; bits != 0U; bits &= bits - 1U) {
+        *cursor++ = base + static_cast<std::uint32_t>(lowest_bit(bits));
+      }
+      continue;
+    }
+    auto const base = _mm_set1_epi32(static_cast<int>(i * BatchWordBits));
+    for (unsigned first = 0U; word != 0U && first < BatchWordBits;
+         first += 4U) {
+      auto const bits = static_cast<unsigned>((word >> first) & 0xfU);
+      std::uint32_t positions;
+      std::memcpy(&positions, t.byte_positions[bits], sizeof(positions));
+      auto const lanes = _mm_add_epi32(
+          _mm_cvtepu8_epi32(_mm_cvtsi32_si128(static_cast<int>(positions))),
+          _mm_set1_epi32(static_cast<int>(first)));
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i*>(cursor + bits_before(word, first)),
+          _mm_add_epi32(lanes, base));
+    }
+    cursor += _mm_popcnt_u64(word);
+  }
+  out = cursor;
+  return i;
+}
+
+// Bit positions of 8 bits per group
+__attribute__((target("avx2,popcnt"))) inline std::size_t error_indices_avx2(
+    BatchWord const* mask, std::size_t words, std::uint32_t*& out,
+    std::uint32_t const* out_end) {
+  auto const& t = tables();
+  auto* cursor = out;
+  std::size_t i = 0U;
+  for (; i < words && out_end - cursor >= 64; ++i) {
+    auto const word = ~mask[i];
+    if (_mm_popcnt_u64(word) <= SparseWordBits) {
+      // few failures are cheaper to walk bit by bit
+      auto const base = static_cast<std::uint32_t>(i * BatchWordBits);
+      for (auto bits = word; bits != 0U; bits &= bits - 1U) {
+        *cursor++ = base + static_cast<std::uint32_t>(lowest_bit(bits));
+      }
+      continue;
+    }
+    auto const base = _mm256_set1_epi32(static_cast<int>(i * BatchWordBits));
+    for (unsigned first = 0U; word != 0U && first < BatchWordBits;
+         first += 8U) {
+      auto const bits = static_cast<unsigned>((word >> first) & 0xffU);
+      auto const lanes = _mm256_add_epi32(
+          _mm256_cvtepu8_epi32(_mm_loadl_epi64(
+              reinterpret_cast<__m128i const*>(t.byte_positions[bits]))),
+          _mm256_set1_epi32(static_cast<int>(first)));
+      _mm256_storeu_si256(
+          reinterpret_cast<__m256i*>(cursor + bits_before(word, first)),
+          _mm256_add_epi32(lanes, base));
+    }
+    cursor += _mm_popcnt_u64(word);
+  }
+  out = cursor;
+  return i;
+}
+
+#else
+
+inline SimdLevel detect_level() noexcept { return SimdLevel::Scalar; }
+
+#endif  // VOE_X86_SIMD
+
+using CompactKernel = std::size_t (*)(char const*, BatchWord const*,
+                                      std::size_t, char*&, char const*);
+
+// Vector kernel for elements of Size bytes, nullptr if there is none
+template <std::size_t Size>
+CompactKernel compact_kernel(SimdLevel level) noexcept {
+#if VOE_X86_SIMD
+  if (level == SimdLevel::Avx2) {
+    return Size == 4U ? compact32_avx2 : Size == 8U ? compact64_avx2 : nullptr;
+  }
+  if (level == SimdLevel::Sse42) {
+    return Size == 4U ? compact32_sse42 : nullptr;
+  }
+#endif
+  static_cast<void>(level);
+  return nullptr;
+}
+
+}  // namespace simd
+}  // namespace detail
+
+// Best level supported by the CPU, detected once
+inline SimdLevel simd_level() noexcept {
+  static SimdLevel const level = detail::simd::detect_level();
+  return level;
+}
+
+// Whether kernels of the level can run on this CPU
+inline bool simd_supported(SimdLevel level) noexcept {
+  return static_cast<int>(level) <= static_cast<int>(simd_level());
+}
+
+// Kernels of a level above simd_level() must not be requested
+template <typename T, typename E>
+std::size_t count_errors(ValueOrErrorBatch<T, E> const& batch,
+                         SimdLevel level = simd_level()) noexcept {
+  auto const& mask = batch.value_mask();
+  std::size_t values = 0U;
+  switch (level) {
+#if VOE_X86_SIMD
+    case SimdLevel::Avx2:
+      values = detail::simd::count_values_avx2(mask.data(), mask.size());
+      break;
+    case SimdLevel::Sse42:
+      values = detail::simd::count_values_sse42(mask.data(), mask.size());
+      break;
+#endif
+    default:
+      values = detail::simd::count_values_scalar(mask.data(), mask.size());
+      break;
+  }
+  return batch.size() - values;
+}
+
+// Copies values of successes to out. Returns their number.
+template <typename T, typename E>
+std::size_t compact_values(ValueOrErrorBatch<T, E> const& batch, T* out,
+                           SimdLevel level = simd_level()) {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Values are copied as bytes");
+  auto const* values = batch.values().data();
+  auto const* mask = batch.value_mask().data();
+  auto const words = batch.value_mask().size();
+  auto const full = detail::simd::full_words(batch.size());
+  std::size_t done = 0U;
+  auto* const first = out;
+  auto const kernel = detail::simd::compact_kernel<sizeof(T)>(level);
+  if (kernel != nullptr) {
+    auto* bytes = reinterpret_cast<char*>(out);
+    done = kernel(reinterpret_cast<char const*>(values), mask, full, bytes,
+                  reinterpret_cast<char const*>(out + batch.value_count()));
+    out = reinterpret_cast<T*>(bytes);
+  }
+  out = detail::simd::compact_values_scalar(values, mask, done, words, out);
+  return static_cast<std::size_t>(out - first);
+}
+
+template <typename T, typename E>
+void compact_values(ValueOrErrorBatch<T, E> const& batch, std::vector<T>& out,
+                    SimdLevel level = simd_level()) {
+  out.resize(batch.value_count());
+  out.resize(compact_values(batch, out.data(), level));
+}
+
+// Writes indices of failures to out. Returns their number.
+template <typename T, typename E>
+std::size_t error_indices(ValueOrErrorBatch<T, E> const& batch,
+                          std::uint32_t* out,
+                          SimdLevel level = simd_level()) noexcept {
+  auto const* mask = batch.value_mask().data();
+  auto const words = batch.value_mask().size();
+  auto const full = detail::simd::full_words(batch.size());
+  auto const* const out_end = out + batch.error_count();
+  auto* const first = out;
+  std::size_t done = 0U;
+  switch (level) {
+#if VOE_X86_SIMD
+    case SimdLevel::Avx2:
+      done = detail::simd::error_indices_avx2(mask, full, out, out_end);
+      break;
+    case SimdLevel::Sse42:
+      done = detail::simd::error_indices_sse42(mask, full, out, out_end);
+      break;
+#endif
+    default:
+      break;
+  }
+  out = detail::simd::error_indices_scalar(
+      mask, done, words, detail::simd::tail_bits(batch.size()), out);
+  return static_cast<std::size_t>(out - first);
+}
+
+template <typename T, typename E>
+void error_indices(ValueOrErrorBatch<T, E> const& batch,
+                   std::vector<std::uint32_t>& out,
+                   SimdLevel level = simd_level()) {
+  out.resize(batch.error_count());
+  out.resize(error_indices(batch, out.data(), level));
+}
+
+}  // namespace rms
@@ -0,0 +1,177 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#pragma once
+
+/*
+ * All values of a range of results or the first error:
+ *
+ *   ValueOrError<std::vector<Customer>> customers =
+ *       rms::transform_collect(ids, get_customer);
+ *
+ * collect(range) takes a range of ValueOrError<T, E>, transform_collect(range,
+ * f) calls f: element -> ValueOrError<T, E> for each element. Both stop at the
+ * first error. Storage is reserved once if size of the range is known. Values
+ * are moved when the range is an rvalue (or come from f), copied otherwise.
+ *
+ * Overloads with std::vector<T>& out reuse the capacity of out and return
+ * ValueOrError<void, E>. On error out holds values before the failed element.
+ */
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "config.h"
+#include "type_traits.h"
+#include "value_or_error.h"
+
+namespace rms {
+namespace detail {
+
+// Number of elements if it is known without walking the range
+template <typename Range>
+auto size_hint(Range const& range, int /*preferred*/)
+    -> decltype(static_cast<std::size_t>(range.size())) {
+  return static_cast<std::size_t>(range.size());
+}
+
+template <typename Range>
+std::size_t size_hint(Range const& range, long /*fallback*/) {  // NOLINT
+  using std::begin;
+  using std::end;
+  using Iterator = decltype(begin(range));
+  using Category = typename std::iterator_traits<Iterator>::iterator_category;
+  return std::is_base_of<std::random_access_iterator_tag, Category>::value
+             ? static_cast<std::size_t>(std::distance(begin(range), end(range)))
+             : 0U;
+}
+
+// Element with the value category of the range
+template <typename Range, typename Element>
+typename std::conditional<std::is_lvalue_reference<Range>::value, Element&,
+                          Element&&>::type
+forward_element(Element& element) noexcept {
+  return static_cast<typename std::conditional<
+      std::is_lvalue_reference<Range>::value, Element&, Element&&>::type>(
+      element);
+}
+
+template <typename Range>
+using range_element_t =
+    decay_t<decltype(*std::begin(std::declval<Range&>()))>;
+
+// Result of collect() into a vector
+template <typename Result>
+using collected_t = ValueOrError<std::vector<typename Result::value_type>,
+                                 typename Result::error_type>;
+
+// Value of item. Rvalue item gives its value away.
+template <typename T, typename E>
+T&& take_value(ValueOrError<T, E>&& item) {
+  return item.extract();
+}
+
+template <typename T, typename E>
+T const& take_value(ValueOrError<T, E>& item) {
+  return item.value();
+}
+
+template <typename T, typename E>
+T const& take_value(ValueOrError<T, E> const& item) {
+  return item.value();
+}
+
+// Errors after the first one are dropped together with the rvalue range.
+// Lvalue range stays with the caller, so its errors are left as is.
+template <typename Iterator>
+VOE_COLD void ignore_rest(std::true_type /*owned*/, Iterator first,
+                          Iterator last) {
+  for (; first != last; ++first) {
+    first->ignore();
+  }
+}
+
+template <typename Iterator>
+void ignore_rest(std::false_type /*owned*/, Iterator, Iterator) {}
+
+template <typename Range, typename Value = typename std::remove_reference<
+                              Range>::type>
+using is_owned_range =
+    std::integral_constant<bool, !std::is_lvalue_reference<Range>::value &&
+                                     !std::is_const<Value>::value>;
+
+}  // namespace detail
+
+template <typename Range,
+          typename Result = detail::range_element_t<Range>,
+          typename T = typename Result::value_type,
+          typename E = typename Result::error_type>
+ValueOrError<void, E> collect(Range&& range, std::vector<T>& out) {
+  static_assert(is_value_or_error<Result>::value,
+                "Range must contain ValueOrError");
+  out.clear();
+  out.reserve(detail::size_hint(range, 0));
+  using std::begin;
+  using std::end;
+  auto last = end(range);
+  for (auto it = begin(range); it != last; ++it) {
+    auto&& item = detail::forward_element<Range>(*it);
+    if (VOE_UNLIKELY(!item.has_value())) {
+      auto error = detail::propagate_error<ValueOrError<void, E>>(item.error());
+      detail::ignore_rest(detail::is_owned_range<Range>(), ++it, last);
+      return error;
+    }
+    out.push_back(detail::take_value(std::forward<decltype(item)>(item)));
+  }
+  return {};
+}
+
+template <typename Range,
+          typename Result = detail::range_element_t<Range>>
+detail::collected_t<Result> collect(Range&& range) {
+  typename detail::collected_t<Result>::value_type values;
+  auto result = collect(std::forward<Range>(range), values);
+  if (VOE_UNLIKELY(!result)) {
+    return detail::propagate_error<detail::collected_t<Result>>(result.error());
+  }
+  return detail::collected_t<Result>(in_place, std::move(values));
+}
+
+template <typename Range, typename F,
+          typename Result = decay_t<invoke_result_t<
+              F&, decltype(detail::forward_element<Range>(
+                      *std::begin(std::declval<Range&>())))>>,
+          typename T = typename Result::value_type,
+          typename E = typename Result::error_type>
+ValueOrError<void, E> transform_collect(Range&& range, F&& f,
+                                        std::vector<T>& out) {
+  static_assert(is_value_or_error<Result>::value,
+                "F must return an ValueOrError");
+  out.clear();
+  out.reserve(detail::size_hint(range, 0));
+  for (auto&& element : range) {
+    auto item = rms::invoke(f, detail::forward_element<Range>(element));
+    if (VOE_UNLIKELY(!item.has_value())) {
+      return detail::propagate_error<ValueOrError<void, E>>(item.error());
+    }
+    out.push_back(item.extract());
+  }
+  return {};
+}
+
+template <typename Range, typename F,
+          typename Result = decay_t<invoke_result_t<
+              F&, decltype(detail::forward_element<Range>(
+                      *std::begin(std::declval<Range&>())))>>>
+detail::collected_t<Result> transform_collect(Range&& range, F&& f) {
+  typename detail::collected_t<Result>::value_type values;
+  auto result =
+      transform_collect(std::forward<Range>(range), std::forward<F>(f), values);
+  if (VOE_UNLIKELY(!result)) {
+    return detail::propagate_error<detail::collected_t<Result>>(result.error());
+  }
+  return detail::collected_t<Result>(in_place, std::move(values));
+}
+
+}  // namespace rms
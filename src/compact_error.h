@@ -0,0 +1,97 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include "value_or_error.h"
+
+namespace rms {
+
+// std::error_code packed into 32 bits: index of the category in
+// ErrorCategoryRegistry in the high 8 bits and the value in the low 24 bits.
+// Conversion from std::error_code throws std::out_of_range if the value does
+// not fit, so conversion back is always lossless.
+class CompactErrorCode {
+ public:
+  static constexpr std::int32_t MaxValue = (1 << 23) - 1;
+  static constexpr std::int32_t MinValue = -(1 << 23);
+
+  CompactErrorCode() noexcept : m_bits(0U) {}
+
+  explicit CompactErrorCode(std::error_code const& error)
+      : m_bits(pack(ErrorCategoryRegistry::index_of(error.category()),
+                    error.value())) {}
+
+  template <typename ErrorEnum,
+            typename std::enable_if<
+                std::is_error_code_enum<ErrorEnum>::value ||
+                std::is_error_condition_enum<ErrorEnum>::value>::type* =
+                nullptr>
+  // cppcheck-suppress noExplicitConstructor
+  CompactErrorCode(ErrorEnum error)  // NOLINT
+      : CompactErrorCode(make_error_code(error)) {}
+
+  std::int32_t value() const noexcept {
+    auto const value = static_cast<std::int32_t>(m_bits & ValueMask);
+    // Sign extension of 24 bit value
+    return (value ^ SignBit) - SignBit;
+  }
+
+  std::uint8_t category_index() const noexcept {
+    return static_cast<std::uint8_t>(m_bits >> ValueBits);
+  }
+
+  std::error_category const& category() const noexcept {
+    return ErrorCategoryRegistry::category(category_index());
+  }
+
+  explicit operator std::error_code() const noexcept {
+    return {value(), category()};
+  }
+
+  explicit operator bool() const noexcept { return value() != 0; }
+
+  std::string message() const { return category().message(value()); }
+
+  std::uint32_t bits() const noexcept { return m_bits; }
+
+  friend bool operator==(CompactErrorCode lhs, CompactErrorCode rhs) noexcept {
+    return lhs.m_bits == rhs.m_bits;
+  }
+
+  friend bool operator!=(CompactErrorCode lhs, CompactErrorCode rhs) noexcept {
+    return lhs.m_bits != rhs.m_bits;
+  }
+
+ private:
+  static constexpr unsigned ValueBits = 24U;
+  static constexpr std::uint32_t ValueMask = (1U << ValueBits) - 1U;
+  static constexpr std::int32_t SignBit = 1 << (ValueBits - 1U);
+
+  static std::uint32_t pack(std::uint8_t category_index, int value) {
+    if (value < MinValue || value > MaxValue) {
+      throw std::out_of_range("Error value does not fit into 24 bits");
+    }
+    return (static_cast<std::uint32_t>(category_index) << ValueBits) |
+           (static_cast<std::uint32_t>(value) & ValueMask);
+  }
+
+  std::uint32_t m_bits;
+};
+
+static_assert(sizeof(CompactErrorCode) == sizeof(std::uint32_t),
+              "CompactErrorCode must be 32 bits");
+static_assert(std::is_trivially_copyable<CompactErrorCode>::value,
+              "CompactErrorCode must be trivially copyable");
+
+// ValueOrError storing the error in 32 bits. Converts to std::error_code at
+// API boundaries through error().
+template <typename T>
+using CompactValueOrError = ValueOrError<T, CompactErrorCode>;
+
+}  // namespace rms
@@ -0,0 +1,68 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#pragma once
+
+// Runtime detection of errors which were never checked.
+// strict: every unhandled error aborts in the dtor of ValueOrError.
+// debug: same as strict unless NDEBUG is defined, otherwise same as off.
+// off: no tracking at all, only compile time [[nodiscard]] diagnostics.
+// The value must be the same for all translation units of the program.
+#define VOE_CHECKING_OFF 0
+#define VOE_CHECKING_DEBUG 1
+#define VOE_CHECKING_STRICT 2
+
+#ifndef VOE_CHECKING
+#define VOE_CHECKING VOE_CHECKING_STRICT
+#endif
+
+#if VOE_CHECKING == VOE_CHECKING_STRICT || \
+    (VOE_CHECKING == VOE_CHECKING_DEBUG && !defined(NDEBUG))
+#define VOE_RUNTIME_CHECKS 1
+#elif VOE_CHECKING == VOE_CHECKING_DEBUG || VOE_CHECKING == VOE_CHECKING_OFF
+#define VOE_RUNTIME_CHECKS 0
+#else
+#error "VOE_CHECKING must be VOE_CHECKING_STRICT, _DEBUG or _OFF"
+#endif
+
+// C++20 coroutines: co_await of ValueOrError inside functions returning
+// ValueOrError (see coroutine.h). Opt-in, needs C++20.
+#ifndef VOE_COROUTINES
+#define VOE_COROUTINES 0
+#endif
+
+#if VOE_COROUTINES && !defined(__cpp_impl_coroutine)
+#error "VOE_COROUTINES needs a compiler with C++20 coroutines"
+#endif
+
+// Discarded results are diagnosed at compile time in every mode. Before C++17
+// clang reports [[nodiscard]] as an extension under -pedantic, so its own
+// attribute is used there. GCC 7+ accepts [[nodiscard]] as C++14 too.
+#if defined(__has_cpp_attribute)
+#define VOE_HAS_CPP_ATTRIBUTE(x) __has_cpp_attribute(x)
+#else
+#define VOE_HAS_CPP_ATTRIBUTE(x) 0
+#endif
+
+#if __cplusplus < 201703L && defined(__clang__)
+#define VOE_NODISCARD [[clang::warn_unused_result]]
+#elif VOE_HAS_CPP_ATTRIBUTE(nodiscard)
+#define VOE_NODISCARD [[nodiscard]]
+#else
+#define VOE_NODISCARD
+#endif
+
+// Branch hints and cold path attributes. Errors are expected to be rare, so
+// error construction and propagation are moved out of the hot path.
+// Define VOE_BRANCH_HINTS=0 to compare the code generated without them.
+#ifndef VOE_BRANCH_HINTS
+#define VOE_BRANCH_HINTS 1
+#endif
+
+#if VOE_BRANCH_HINTS && (defined(__GNUC__) || defined(__clang__))
+#define VOE_LIKELY(x) __builtin_expect(!!(x), 1)
+#define VOE_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#define VOE_COLD __attribute__((cold, noinline))
+#else
+#define VOE_LIKELY(x) (x)
+#define VOE_UNLIKELY(x) (x)
+#define VOE_COLD
+#endif
@@ -0,0 +1,318 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#pragma once
+
+/*
+ * Coroutines returning ValueOrError (C++20, opt-in with VOE_COROUTINES=1):
+ *
+ *   ValueOrError<bool> is_active_admin(DBManager const& db) {
+ *     auto customer = co_await db.get_active_customer();
+ *     bool const auth = co_await db.is_auth(customer);
+ *     if (!auth) {
+ *       co_return false;
+ *     }
+ *     co_return co_await db.is_admin(customer);
+ *   }
+ *
+ * co_await of ValueOrError<U, E> gives the value: U moved out of an rvalue
+ * (so it does not dangle as the reference of VOE_TRY_EXTRACT does), U& of an
+ * lvalue. An error finishes the coroutine with that error right away, as
+ * VOE_TRY does, but from the middle of any expression. co_return takes
+ * anything ValueOrError<T, E> is constructible from, `co_return {};` is the
+ * success of ValueOrError<void>. Errors are converted through
+ * std::error_code, as in then(). Only ValueOrError can be awaited.
+ *
+ * The coroutine runs to completion before the call returns and writes its
+ * result straight into the returned object. A coroutine stopped by an
+ * awaited error stays suspended, its frame is destroyed by the returned
+ * object once the coroutine is left, never from inside the coroutine.
+ * Compilers don't elide such frames, so they are taken from FramePool
+ * instead of the heap. Exceptions are kept in the returned object and
+ * rethrown to the caller.
+ *
+ * Some compilers get code generation for such coroutines wrong (GCC 12
+ * crashes destroying a frame stopped in the condition of an if statement
+ * and frees a frame twice when an exception is rethrown).
+ * tools/coroutine_check.cc checks for that and CMake refuses VOE_COROUTINES
+ * where it fails, other build systems should run it too.
+ */
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <system_error>
+#include <utility>
+
+#include "config.h"
+#include "value_or_error.h"
+
+#if !VOE_COROUTINES
+#error "coroutine.h needs VOE_COROUTINES=1"
+#endif
+
+namespace rms {
+namespace detail {
+
+// Recycles coroutine frames. Freed blocks are kept in per thread free lists
+// by size class, so a frame of the same size is reused without locks and
+// without a call to the allocator. A frame freed on another thread goes to
+// the lists of that thread.
+class FramePool {
+ public:
+  static void* allocate(std::size_t size) {
+    auto const index = size_class(size);
+    if (VOE_UNLIKELY(index >= SizeClasses)) {
+      return ::operator new(size);
+    }
+    auto& list = local().lists[index];
+    if (VOE_LIKELY(list.head != nullptr)) {
+      auto* block = list.head;
+      list.head = block->next;
+      --list.count;
+      return block;
+    }
+    return ::operator new((index + 1U) * Granularity);
+  }
+
+  static void deallocate(void* frame, std::size_t size) noexcept {
+    auto const index = size_class(size);
+    if (VOE_LIKELY(index < SizeClasses)) {
+      auto& list = local().lists[index];
+      if (VOE_LIKELY(list.count < MaxCachedBlocks)) {
+        list.head = ::new (frame) Block{list.head};
+        ++list.count;
+        return;
+      }
+    }
+    ::operator delete(frame);
+  }
+
+ private:
+  static constexpr std::size_t Granularity = 64U;
+  // Frames up to 1 KiB are pooled
+  static constexpr std::size_t SizeClasses = 16U;
+  static constexpr std::size_t MaxCachedBlocks = 64U;
+
+  struct Block {
+    Block* next;
+  };
+
+  struct FreeList {
+    Block* head = nullptr;
+    std::size_t count = 0U;
+  };
+
+  struct Lists {
+    Lists() = default;
+    Lists(Lists const&) = delete;
+    Lists& operator=(Lists const&) = delete;
+
+    ~Lists() {
+      for (auto& list : lists) {
+        while (list.head != nullptr) {
+          auto* block = list.head;
+          list.head = block->next;
+          ::operator delete(block);
+        }
+      }
+    }
+
+    FreeList lists[SizeClasses];
+  };
+
+  static std::size_t size_class(std::size_t size) noexcept {
+    return (size - 1U) / Granularity;
+  }
+
+  static Lists& local() noexcept {
+    thread_local Lists lists;
+    return lists;
+  }
+};
+
+// Awaiting of a ValueOrError which holds a value does not suspend. An error
+// is passed to the promise of the awaiting coroutine, which finishes it.
+template <typename Result, typename Promise>
+class ValueOrErrorAwaiter {
+ public:
+  ValueOrErrorAwaiter(Result& result, Promise& promise) noexcept
+      : m_result(result), m_promise(promise) {}
+
+  bool await_ready() const noexcept {
+    return VOE_LIKELY(m_result.has_value());
+  }
+
+  decltype(auto) await_suspend(std::coroutine_handle<> handle) {
+    return m_promise.propagate(m_result.error(), handle);
+  }
+
+ protected:
+  Result& m_result;
+  Promise& m_promise;
+};
+
+// Moves the value out of an awaited rvalue
+template <typename T, typename E, typename Promise>
+class ExtractAwaiter
+    : public ValueOrErrorAwaiter<ValueOrError<T, E>, Promise> {
+ public:
+  using ValueOrErrorAwaiter<ValueOrError<T, E>, Promise>::ValueOrErrorAwaiter;
+
+  T await_resume() { return this->m_result.extract(); }
+};
+
+// Refers to the value of an awaited lvalue
+template <typename Result, typename Promise>
+class BorrowAwaiter : public ValueOrErrorAwaiter<Result, Promise> {
+ public:
+  using ValueOrErrorAwaiter<Result, Promise>::ValueOrErrorAwaiter;
+
+  decltype(auto) await_resume() { return this->m_result.value(); }
+};
+
+template <typename T, typename E>
+class ValueOrErrorPromise;
+
+// Returned by get_return_object(). Depending on the compiler it is converted
+// to ValueOrError either after the body stops or before the body runs. In
+// the first case the promise sets the result or the exception here and the
+// frame of a coroutine stopped by an error is destroyed by the conversion.
+// In the second case the promise sets the returned object itself and
+// destroys the frame.
+template <typename T, typename E>
+class CoroutineResult {
+ public:
+  using result_type = ValueOrError<T, E>;
+
+  explicit CoroutineResult(ValueOrErrorPromise<T, E>& promise) noexcept
+      : m_promise(promise) {
+    promise.set_owner(*this);
+  }
+
+  CoroutineResult(CoroutineResult const&) = delete;
+  CoroutineResult& operator=(CoroutineResult const&) = delete;
+
+  // NOLINTNEXTLINE(runtime/explicit)
+  operator result_type() {
+    if (!m_done) {
+      return result_type(coroutine_result_t(), m_promise);
+    }
+    if (VOE_UNLIKELY(m_frame)) {
+      m_frame.destroy();
+    }
+    if (VOE_UNLIKELY(m_exception != nullptr)) {
+      std::rethrow_exception(m_exception);
+    }
+    return std::move(m_result);
+  }
+
+ private:
+  friend class ValueOrErrorPromise<T, E>;
+
+  // Not used once m_done is set, the promise may be destroyed by then
+  ValueOrErrorPromise<T, E>& m_promise;
+  result_type m_result;
+  std::exception_ptr m_exception;
+  // Frame suspended at the awaited error
+  std::coroutine_handle<> m_frame;
+  bool m_done = false;
+};
+
+template <typename T, typename E>
+class ValueOrErrorPromise {
+ public:
+  using result_type = ValueOrError<T, E>;
+
+  static void* operator new(std::size_t size) {
+    return FramePool::allocate(size);
+  }
+
+  static void operator delete(void* frame, std::size_t size) noexcept {
+    FramePool::deallocate(frame, size);
+  }
+
+  CoroutineResult<T, E> get_return_object() noexcept {
+    return CoroutineResult<T, E>(*this);
+  }
+
+  std::suspend_never initial_suspend() const noexcept { return {}; }
+
+  std::suspend_never final_suspend() const noexcept { return {}; }
+
+  void return_value(result_type&& result) {
+    *m_result = std::move(result);
+    finish();
+  }
+
+  // Without an owner the exception can only leave the coroutine right away
+  void unhandled_exception() {
+    if (VOE_UNLIKELY(m_owner == nullptr)) {
+      throw;
+    }
+    m_owner->m_exception = std::current_exception();
+    finish();
+  }
+
+  template <typename U, typename OtherE>
+  ExtractAwaiter<U, OtherE, ValueOrErrorPromise> await_transform(
+      ValueOrError<U, OtherE>&& result) noexcept {
+    return {result, *this};
+  }
+
+  template <typename U, typename OtherE>
+  BorrowAwaiter<ValueOrError<U, OtherE>, ValueOrErrorPromise> await_transform(
+      ValueOrError<U, OtherE>& result) noexcept {
+    return {result, *this};
+  }
+
+  template <typename U, typename OtherE>
+  BorrowAwaiter<ValueOrError<U, OtherE> const, ValueOrErrorPromise>
+  await_transform(ValueOrError<U, OtherE> const& result) noexcept {
+    return {result, *this};
+  }
+
+  // The error is the result, the rest of the coroutine is skipped. The frame
+  // is never destroyed here, while the coroutine is still running: its owner
+  // destroys it once the call returns.
+  VOE_COLD void propagate(std::error_code error,
+                          std::coroutine_handle<> handle) {
+    *m_result = propagate_error<result_type>(error);
+    if (m_owner != nullptr) {
+      m_owner->m_frame = handle;
+      finish();
+    } else {
+      handle.destroy();
+    }
+  }
+
+  // Called by the returned object before the body runs
+  void set_result_object(result_type& result) noexcept {
+    m_result = &result;
+    m_owner = nullptr;
+  }
+
+  void set_owner(CoroutineResult<T, E>& owner) noexcept {
+    m_result = &owner.m_result;
+    m_owner = &owner;
+  }
+
+ private:
+  void finish() noexcept {
+    if (m_owner != nullptr) {
+      m_owner->m_done = true;
+    }
+  }
+
+  result_type* m_result = nullptr;
+  CoroutineResult<T, E>* m_owner = nullptr;
+};
+
+}  // namespace detail
+}  // namespace rms
+
+namespace std {
+template <typename T, typename E, typename... ArgTypes>
+struct coroutine_traits<rms::ValueOrError<T, E>, ArgTypes...> {
+  using promise_type = rms::detail::ValueOrErrorPromise<T, E>;
+};
+}  // namespace std
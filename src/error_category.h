@@ -0,0 +1,244 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+namespace rms {
+
+class StaticMessageCategory;
+
+// Maps error categories to small indices, so an error fits into 32 bits
+// (CompactErrorCode). Categories are registered on first use. They may also
+// register themselves in their ctor to get the index at startup, which
+// StaticMessageCategory does. Indices are stable for the lifetime of the
+// program, but not across programs. StaticMessageCategory instances are also
+// kept in a hash table by address, so they are recognized in constant time.
+class ErrorCategoryRegistry {
+ public:
+  static constexpr std::size_t Capacity = 256U;
+
+  // Index of the category. Registers it if it is unknown.
+  // Throws std::length_error if the registry is full.
+  static std::uint8_t index_of(std::error_category const& category) {
+    return instance().find_or_add(category);
+  }
+
+  // Category registered with the index. Must be obtained from index_of.
+  static std::error_category const& category(std::uint8_t index) noexcept {
+    return *instance().m_categories[index].load(std::memory_order_acquire);
+  }
+
+  static std::size_t size() noexcept {
+    return instance().m_size.load(std::memory_order_acquire);
+  }
+
+  // The category as StaticMessageCategory or nullptr. Cheaper than
+  // dynamic_cast: a lookup by address which usually hits an empty slot for
+  // other categories. Does not register the category.
+  static StaticMessageCategory const* static_message_category(
+      std::error_category const& category) noexcept;
+
+ private:
+  friend class StaticMessageCategory;
+
+  // Twice the capacity, so probe sequences stay short
+  static constexpr unsigned StaticSlotBits = 9U;
+  static constexpr std::size_t StaticSlots = std::size_t{1} << StaticSlotBits;
+  static_assert(StaticSlots == 2U * Capacity, "StaticSlotBits mismatch");
+
+  ErrorCategoryRegistry() noexcept {
+    for (auto& category : m_categories) {
+      category.store(nullptr, std::memory_order_relaxed);
+    }
+    for (auto& category : m_static_categories) {
+      category.store(nullptr, std::memory_order_relaxed);
+    }
+    for (auto& static_messages : m_static_messages) {
+      static_messages.store(false, std::memory_order_relaxed);
+    }
+    m_categories[0].store(&std::system_category(), std::memory_order_relaxed);
+    m_categories[1].store(&std::generic_category(), std::memory_order_relaxed);
+    m_size.store(2U, std::memory_order_release);
+  }
+
+  static ErrorCategoryRegistry& instance() noexcept {
+    static ErrorCategoryRegistry registry;
+    return registry;
+  }
+
+  std::uint8_t find_or_add(std::error_category const& category) {
+    auto const size = m_size.load(std::memory_order_acquire);
+    auto const index = find(category, 0U, size);
+    if (index < size) {
+      return static_cast<std::uint8_t>(index);
+    }
+    return add(category, size);
+  }
+
+  std::uint8_t add(std::error_category const& category, std::size_t checked) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto const size = m_size.load(std::memory_order_relaxed);
+    auto const index = find(category, checked, size);
+    if (index < size) {
+      return static_cast<std::uint8_t>(index);
+    }
+    if (size == Capacity) {
+      throw std::length_error("Too many error categories");
+    }
+    m_categories[size].store(&category, std::memory_order_relaxed);
+    m_size.store(size + 1U, std::memory_order_release);
+    return static_cast<std::uint8_t>(size);
+  }
+
+  // Registers the category and flags it in its slot of the hash table. Slots
+  // are never freed, at most Capacity of them are taken.
+  std::size_t add_static_messages(std::error_category const& category) {
+    find_or_add(category);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto slot = slot_of(category);
+    for (;;) {
+      auto const* entry =
+          m_static_categories[slot].load(std::memory_order_relaxed);
+      if (entry == nullptr) {
+        m_static_categories[slot].store(&category, std::memory_order_release);
+        break;
+      }
+      if (entry == &category) {
+        break;
+      }
+      slot = (slot + 1U) % StaticSlots;
+    }
+    set_static_messages(slot, true);
+    return slot;
+  }
+
+  void set_static_messages(std::size_t slot, bool static_messages) noexcept {
+    m_static_messages[slot].store(static_messages, std::memory_order_release);
+  }
+
+  // Slot of the category or of the empty slot which ends its probe sequence
+  std::size_t find_static_slot(
+      std::error_category const& category) const noexcept {
+    auto slot = slot_of(category);
+    for (;;) {
+      auto const* entry =
+          m_static_categories[slot].load(std::memory_order_acquire);
+      if (entry == nullptr || entry == &category) {
+        return slot;
+      }
+      slot = (slot + 1U) % StaticSlots;
+    }
+  }
+
+  // Fibonacci hashing of the address, its low bits are alignment only
+  static std::size_t slot_of(std::error_category const& category) noexcept {
+    auto const address =
+        static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(&category));
+    return static_cast<std::size_t>((address * 0x9E3779B97F4A7C15ULL) >>
+                                    (64U - StaticSlotBits));
+  }
+
+  // Categories are compared by address as std::error_category does
+  std::size_t find(std::error_category const& category, std::size_t first,
+                   std::size_t last) const noexcept {
+    for (auto i = first; i < last; ++i) {
+      if (m_categories[i].load(std::memory_order_relaxed) == &category) {
+        return i;
+      }
+    }
+    return last;
+  }
+
+  std::array<std::atomic<std::error_category const*>, Capacity> m_categories;
+  // Open addressing hash table of StaticMessageCategory instances
+  std::array<std::atomic<std::error_category const*>, StaticSlots>
+      m_static_categories;
+  // Cleared when the category of the slot is destroyed
+  std::array<std::atomic<bool>, StaticSlots> m_static_messages;
+  std::atomic<std::size_t> m_size;
+  std::mutex m_mutex;
+};
+
+// Error category whose messages are static strings, e.g. a table of enum
+// names. std::error_category::message() returns std::string, this gives the
+// message without allocation. operator<< of ValueOrError uses it for errors
+// of such categories.
+class StaticMessageCategory : public std::error_category {
+ public:
+  // Message of the error value, must be valid for the program lifetime.
+  // Never null, "" for unknown values.
+  virtual char const* message_chars(int error_value) const noexcept = 0;
+
+#if __cplusplus >= 201703L
+  std::string_view message_view(int error_value) const noexcept {
+    return message_chars(error_value);
+  }
+#endif
+
+  std::string message(int error_value) const override {
+    return message_chars(error_value);
+  }
+
+ protected:
+  // Registers the category in ErrorCategoryRegistry.
+  // Throws std::length_error if the registry is full.
+  StaticMessageCategory()
+      : m_slot(ErrorCategoryRegistry::instance().add_static_messages(*this)) {}
+
+  // Another category may be created at the same address
+  ~StaticMessageCategory() override {
+    ErrorCategoryRegistry::instance().set_static_messages(m_slot, false);
+  }
+
+ private:
+  std::size_t const m_slot;
+};
+
+inline StaticMessageCategory const*
+ErrorCategoryRegistry::static_message_category(
+    std::error_category const& category) noexcept {
+  auto const& registry = instance();
+  auto const slot = registry.find_static_slot(category);
+  if (registry.m_static_messages[slot].load(std::memory_order_acquire)) {
+    return static_cast<StaticMessageCategory const*>(&category);
+  }
+  return nullptr;
+}
+
+namespace detail {
+
+template <typename Error>
+auto static_message(Error const& error, int) noexcept  // NOLINT
+    -> decltype(error.category(), static_cast<char const*>(nullptr)) {
+  auto const* category =
+      ErrorCategoryRegistry::static_message_category(error.category());
+  return category != nullptr ? category->message_chars(error.value())
+                             : nullptr;
+}
+
+template <typename Error>
+char const* static_message(Error const&, ...) noexcept {
+  return nullptr;
+}
+
+}  // namespace detail
+
+// Static message of the error (std::error_code, std::error_condition,
+// CompactErrorCode) or nullptr if its category is not a
+// StaticMessageCategory, or the error has no category at all.
+template <typename Error>
+char const* static_message(Error const& error) noexcept {
+  return detail::static_message(error, 0);
+}
+
+}  // namespace rms
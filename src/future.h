@@ -0,0 +1,417 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#pragma once
+
+/*
+ * Single-shot asynchronous ValueOrError:
+ *
+ *   rms::Promise<std::string> promise;
+ *   auto is_auth = promise.get_future().then_async(
+ *       pool, [&db](std::string const& customer) {
+ *         return db.is_auth(customer);
+ *       });
+ *   promise.set_value("John");
+ *   ValueOrError<bool> auth = std::move(is_auth).get();
+ *
+ * Promise and Future share a state which holds the result and at most one
+ * continuation. Fulfilment and attachment each set their own bit in an atomic
+ * flags word, whoever comes second runs the continuation, so neither side
+ * takes a lock. Only the blocking get() waits on a condition variable and
+ * only when the result is not ready yet.
+ *
+ * then_async(executor, f) posts f: T -> ValueOrError<U, E> (same as then())
+ * to the executor (anything with post(task), e.g. ThreadPool or
+ * InlineExecutor) once the result is ready. Errors are propagated to the
+ * returned Future without posting. on_result(f) calls f(ValueOrError<T, E>&&)
+ * on the thread which makes the result ready (or the calling thread if it is
+ * ready already). The executor must outlive pending continuations.
+ *
+ * A Promise breaks in its noexcept dtor or move assignment, which runs the
+ * attached continuation right away. So f of on_result() must be noexcept
+ * (checked at compile time). If post() of then_async() throws, the posted
+ * task is dropped and the returned Future gets broken_promise.
+ *
+ * async(executor, f) runs f: () -> ValueOrError<U, E> on the executor.
+ *
+ * Futures are consumed by get(), then_async() and on_result(). A Promise
+ * destroyed without a result breaks the promise:
+ * std::future_errc::broken_promise is set. A result which is never consumed
+ * is destroyed as any other ValueOrError, so its unchecked error is reported.
+ * Exceptions are results nobody could consume (get_future() was never
+ * called) and broken_promise itself, which are dropped silently.
+ */
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include "config.h"
+#include "type_traits.h"
+#include "value_or_error.h"
+
+namespace rms {
+
+template <typename T, typename E = std::error_code>
+class Future;
+
+template <typename T, typename E = std::error_code>
+class Promise;
+
+// Runs posted tasks right away on the calling thread
+struct InlineExecutor {
+  template <typename F>
+  void post(F&& f) {
+    f();
+  }
+};
+
+namespace detail {
+
+template <typename T, typename E>
+class Continuation {
+ public:
+  virtual ~Continuation() = default;
+  virtual void run(ValueOrError<T, E>&& result) noexcept = 0;
+};
+
+template <typename T, typename E, typename F>
+class ContinuationImpl final : public Continuation<T, E> {
+ public:
+  template <typename U>
+  explicit ContinuationImpl(U&& f) : m_f(std::forward<U>(f)) {}
+
+  void run(ValueOrError<T, E>&& result) noexcept override {
+    m_f(std::move(result));
+  }
+
+ private:
+  F m_f;
+};
+
+// Owned by the Promise and the Future, the last one deletes it
+template <typename T, typename E>
+class FutureState {
+ public:
+  using result_type = ValueOrError<T, E>;
+
+  FutureState() = default;
+  FutureState(FutureState const&) = delete;
+  FutureState& operator=(FutureState const&) = delete;
+
+  void set_result(result_type&& result) {
+    m_result = std::move(result);
+    complete(HasResult);
+  }
+
+  VOE_COLD void break_promise() noexcept {
+    m_result =
+        result_type(std::make_error_code(std::future_errc::broken_promise));
+    complete(HasResult | BrokenPromise);
+  }
+
+  template <typename F>
+  void set_continuation(F&& f) {
+    m_continuation.reset(
+        new ContinuationImpl<T, E, decay_t<F>>(std::forward<F>(f)));
+    if (m_flags.fetch_or(HasContinuation, std::memory_order_acq_rel) &
+        HasResult) {
+      fire();
+    }
+  }
+
+  bool is_ready() const noexcept {
+    return (m_flags.load(std::memory_order_acquire) & HasResult) != 0U;
+  }
+
+  // Only when ready and no continuation is attached
+  result_type take() noexcept { return std::move(m_result); }
+
+  void acquire() noexcept { m_refs.fetch_add(1, std::memory_order_relaxed); }
+
+  void set_retrieved() noexcept {
+    m_flags.fetch_or(HasFuture, std::memory_order_relaxed);
+  }
+
+  void release() noexcept {
+    if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+
+ private:
+  enum : std::uint8_t {
+    HasResult = 1U,
+    HasContinuation = 2U,
+    HasFuture = 4U,
+    BrokenPromise = 8U
+  };
+
+  // A result left here was never given to a consumer. Unless nobody could
+  // consume it or it only tells that the promise was broken, it is checked
+  // as any other ValueOrError.
+  ~FutureState() {
+    auto const flags = m_flags.load(std::memory_order_relaxed);
+    if ((flags & HasFuture) == 0U || (flags & BrokenPromise) != 0U) {
+      m_result.ignore();
+    }
+  }
+
+  void complete(std::uint8_t flags) noexcept {
+    if (m_flags.fetch_or(flags, std::memory_order_acq_rel) & HasContinuation) {
+      fire();
+    }
+  }
+
+  void fire() noexcept {
+    m_continuation->run(std::move(m_result));
+    m_continuation.reset();
+  }
+
+  std::atomic<std::uint8_t> m_flags{0U};
+  std::atomic<int> m_refs{1};
+  result_type m_result;
+  std::unique_ptr<Continuation<T, E>> m_continuation;
+};
+
+// Blocking get() of a Future which is not ready
+template <typename T, typename E>
+class Waiter {
+ public:
+  void set(ValueOrError<T, E>&& result) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_result = std::move(result);
+    m_ready = true;
+    m_condition.notify_one();
+  }
+
+  ValueOrError<T, E> get() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait(lock, [this] { return m_ready; });
+    return std::move(m_result);
+  }
+
+ private:
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  bool m_ready = false;
+  ValueOrError<T, E> m_result;
+};
+
+template <typename T, typename E, typename F>
+using then_result_t = decay_t<decltype(
+    std::declval<ValueOrError<T, E>>().then(std::declval<F&>()))>;
+
+}  // namespace detail
+
+template <typename T, typename E>
+class VOE_NODISCARD Future {
+ public:
+  using value_type = T;
+  using error_type = E;
+  using result_type = ValueOrError<T, E>;
+
+  Future() noexcept = default;
+
+  Future(Future&& other) noexcept : m_state(other.m_state) {
+    other.m_state = nullptr;
+  }
+
+  Future& operator=(Future&& other) noexcept {
+    if (this != &other) {
+      reset();
+      m_state = other.m_state;
+      other.m_state = nullptr;
+    }
+    return *this;
+  }
+
+  Future(Future const&) = delete;
+  Future& operator=(Future const&) = delete;
+
+  ~Future() { reset(); }
+
+  // False for default constructed and consumed futures
+  bool valid() const noexcept { return m_state != nullptr; }
+
+  bool is_ready() const noexcept {
+    assert(valid());
+    return m_state->is_ready();
+  }
+
+  // Waits for the result
+  result_type get() && {
+    assert(valid());
+    if (m_state->is_ready()) {
+      auto result = m_state->take();
+      reset();
+      return result;
+    }
+    detail::Waiter<T, E> waiter;
+    std::move(*this).on_result(
+        [&waiter](result_type&& result) noexcept {
+          waiter.set(std::move(result));
+        });
+    return waiter.get();
+  }
+
+  template <typename F>
+  void on_result(F&& f) && {
+    static_assert(
+        noexcept(std::declval<decay_t<F>&>()(std::declval<result_type&&>())),
+        "F must be noexcept, a broken promise calls it from noexcept dtor");
+    assert(valid());
+    auto* state = m_state;
+    m_state = nullptr;
+    state->set_continuation(std::forward<F>(f));
+    state->release();
+  }
+
+  template <typename Executor, typename F,
+            typename Next = detail::then_result_t<T, E, decay_t<F>>>
+  Future<typename Next::value_type, typename Next::error_type> then_async(
+      Executor& executor, F&& f) && {
+    static_assert(is_value_or_error<Next>::value,
+                  "F must return an ValueOrError");
+    Promise<typename Next::value_type, typename Next::error_type> promise;
+    auto future = promise.get_future();
+    std::move(*this).on_result(
+        [&executor, promise = std::move(promise),
+         f = decay_t<F>(std::forward<F>(f))](
+            result_type&& result) mutable noexcept {
+          if (VOE_UNLIKELY(!result.has_value())) {
+            promise.set_result(detail::propagate_error<Next>(result.error()));
+            return;
+          }
+          try {
+            executor.post([promise = std::move(promise), f = std::move(f),
+                           result = std::move(result)]() mutable {
+              promise.set_result(std::move(result).then(f));
+            });
+          } catch (...) {
+            // The task which owns the promise is destroyed and breaks it
+          }
+        });
+    return future;
+  }
+
+ private:
+  friend class Promise<T, E>;
+
+  explicit Future(detail::FutureState<T, E>* state) noexcept
+      : m_state(state) {}
+
+  void reset() noexcept {
+    if (m_state != nullptr) {
+      m_state->release();
+      m_state = nullptr;
+    }
+  }
+
+  detail::FutureState<T, E>* m_state = nullptr;
+};
+
+template <typename T, typename E>
+class Promise {
+ public:
+  using result_type = ValueOrError<T, E>;
+
+  Promise() : m_state(new detail::FutureState<T, E>()) {}
+
+  Promise(Promise&& other) noexcept
+      : m_state(other.m_state), m_retrieved(other.m_retrieved) {
+    other.m_state = nullptr;
+  }
+
+  Promise& operator=(Promise&& other) noexcept {
+    if (this != &other) {
+      if (VOE_UNLIKELY(m_state != nullptr)) {
+        break_promise();
+      }
+      m_state = other.m_state;
+      m_retrieved = other.m_retrieved;
+      other.m_state = nullptr;
+    }
+    return *this;
+  }
+
+  Promise(Promise const&) = delete;
+  Promise& operator=(Promise const&) = delete;
+
+  ~Promise() {
+    if (VOE_UNLIKELY(m_state != nullptr)) {
+      break_promise();
+    }
+  }
+
+  // Can be called once
+  Future<T, E> get_future() {
+    assert(m_state != nullptr && !m_retrieved);
+    m_retrieved = true;
+    m_state->acquire();
+    m_state->set_retrieved();
+    return Future<T, E>(m_state);
+  }
+
+  // Can be called once, as well as set_value() and set_error()
+  void set_result(result_type&& result) {
+    assert(m_state != nullptr);
+    auto* state = m_state;
+    m_state = nullptr;
+    state->set_result(std::move(result));
+    state->release();
+  }
+
+  template <typename... ArgTypes>
+  void set_value(ArgTypes&&... args) {
+    set_result(result_type(in_place, std::forward<ArgTypes>(args)...));
+  }
+
+  template <typename Error>
+  void set_error(Error&& error) {
+    set_result(result_type(std::forward<Error>(error)));
+  }
+
+ private:
+  VOE_COLD void break_promise() noexcept {
+    auto* state = m_state;
+    m_state = nullptr;
+    state->break_promise();
+    state->release();
+  }
+
+  detail::FutureState<T, E>* m_state;
+  bool m_retrieved = false;
+};
+
+// Future which is ready with result
+template <typename T, typename E>
+Future<T, E> make_ready_future(ValueOrError<T, E>&& result) {
+  Promise<T, E> promise;
+  auto future = promise.get_future();
+  promise.set_result(std::move(result));
+  return future;
+}
+
+// Runs f: () -> ValueOrError<U, E> on the executor
+template <typename Executor, typename F,
+          typename Result = decay_t<invoke_result_t<decay_t<F>&>>>
+Future<typename Result::value_type, typename Result::error_type> async(
+    Executor& executor, F&& f) {
+  static_assert(is_value_or_error<Result>::value,
+                "F must return an ValueOrError");
+  Promise<typename Result::value_type, typename Result::error_type> promise;
+  auto future = promise.get_future();
+  executor.post([promise = std::move(promise),
+                 f = decay_t<F>(std::forward<F>(f))]() mutable {
+    promise.set_result(rms::invoke(f));
+  });
+  return future;
+}
+
+}  // namespace rms
@@ -0,0 +1,244 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#pragma once
+
+/*
+ * Combinators of concurrent futures:
+ *
+ *   auto lookups = rms::when_all(rms::async(pool, get_customer),
+ *                                rms::async(pool, get_permissions));
+ *   ValueOrError<std::tuple<Customer, Permissions>> both =
+ *       std::move(lookups).get();
+ *
+ * when_all(futures...) is ready with the tuple of all values, or with the
+ * first error as soon as it arrives, without waiting for the rest. The
+ * overload for std::vector<Future<T, E>> gives std::vector<T>.
+ *
+ * when_any(futures...) of the same T is ready with the first value. If every
+ * input fails it is ready with the error of the first input (in order of
+ * arguments), since std::error_code can't hold all of them.
+ *
+ * Inputs report to a shared state through Future::on_result(). Completion is
+ * decided by an atomic counter of outstanding inputs and an atomic flag set
+ * by the winner, so the result is set exactly once and without locks.
+ * Results which lose the race are dropped (their errors count as handled).
+ * Values must not be void.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "config.h"
+#include "future.h"
+#include "value_or_error.h"
+
+namespace rms {
+namespace detail {
+
+template <bool... Values>
+using all_true = std::is_same<std::integer_sequence<bool, true, Values...>,
+                              std::integer_sequence<bool, Values..., true>>;
+
+// Results are kept as ValueOrError, so values need no default constructor
+template <typename E, typename... Types>
+class WhenAllState {
+ public:
+  using value_type = std::tuple<Types...>;
+
+  explicit WhenAllState(Promise<value_type, E>&& promise)
+      : m_promise(std::move(promise)) {}
+
+  template <std::size_t Index, typename T>
+  void set(ValueOrError<T, E>&& result) {
+    if (VOE_UNLIKELY(!result.has_value())) {
+      fail(result.error());
+    } else {
+      std::get<Index>(m_results) = std::move(result);
+    }
+    if (m_remaining.fetch_sub(1U, std::memory_order_acq_rel) == 1U &&
+        !m_failed.load(std::memory_order_relaxed)) {
+      complete(std::index_sequence_for<Types...>());
+    }
+  }
+
+ private:
+  VOE_COLD void fail(std::error_code error) {
+    if (!m_failed.exchange(true, std::memory_order_relaxed)) {
+      m_promise.set_error(error);
+    }
+  }
+
+  template <std::size_t... Indices>
+  void complete(std::index_sequence<Indices...>) {
+    m_promise.set_value(std::get<Indices>(m_results).extract()...);
+  }
+
+  std::atomic<std::size_t> m_remaining{sizeof...(Types)};
+  std::atomic<bool> m_failed{false};
+  std::tuple<ValueOrError<Types, E>...> m_results;
+  Promise<value_type, E> m_promise;
+};
+
+template <typename T, typename E>
+class WhenAllVectorState {
+ public:
+  using value_type = std::vector<T>;
+
+  WhenAllVectorState(std::size_t size, Promise<value_type, E>&& promise)
+      : m_remaining(size), m_results(size), m_promise(std::move(promise)) {}
+
+  void set(std::size_t index, ValueOrError<T, E>&& result) {
+    if (VOE_UNLIKELY(!result.has_value())) {
+      fail(result.error());
+    } else {
+      m_results[index] = std::move(result);
+    }
+    if (m_remaining.fetch_sub(1U, std::memory_order_acq_rel) == 1U &&
+        !m_failed.load(std::memory_order_relaxed)) {
+      value_type values;
+      values.reserve(m_results.size());
+      for (auto& item : m_results) {
+        values.push_back(item.extract());
+      }
+      m_promise.set_value(std::move(values));
+    }
+  }
+
+ private:
+  VOE_COLD void fail(std::error_code error) {
+    if (!m_failed.exchange(true, std::memory_order_relaxed)) {
+      m_promise.set_error(error);
+    }
+  }
+
+  std::atomic<std::size_t> m_remaining;
+  std::atomic<bool> m_failed{false};
+  std::vector<ValueOrError<T, E>> m_results;
+  Promise<value_type, E> m_promise;
+};
+
+template <typename T, typename E>
+class WhenAnyState {
+ public:
+  WhenAnyState(std::size_t size, Promise<T, E>&& promise)
+      : m_remaining(size), m_promise(std::move(promise)) {}
+
+  void set(std::size_t index, ValueOrError<T, E>&& result) {
+    if (VOE_LIKELY(result.has_value())) {
+      if (!m_done.exchange(true, std::memory_order_relaxed)) {
+        m_promise.set_result(std::move(result));
+      }
+      return;
+    }
+    if (index == 0U) {
+      m_first_error = result.error();
+    } else {
+      result.ignore();
+    }
+    if (m_remaining.fetch_sub(1U, std::memory_order_acq_rel) == 1U &&
+        !m_done.exchange(true, std::memory_order_relaxed)) {
+      m_promise.set_error(m_first_error);
+    }
+  }
+
+ private:
+  // Failures only, a success completes the result right away
+  std::atomic<std::size_t> m_remaining;
+  std::atomic<bool> m_done{false};
+  // Reported when every input fails, published by the counter
+  std::error_code m_first_error;
+  Promise<T, E> m_promise;
+};
+
+template <typename State, typename... Futures, std::size_t... Indices>
+void subscribe_all(std::shared_ptr<State> const& state,
+                   std::index_sequence<Indices...>, Futures&&... futures) {
+  using Expand = int[];
+  (void)Expand{0, (std::move(futures).on_result(
+                       [state](auto&& result) noexcept {
+                         state->template set<Indices>(std::move(result));
+                       }),
+                   0)...};
+}
+
+template <typename State, typename Future>
+void subscribe_any(std::shared_ptr<State> const& state, std::size_t index,
+                   Future&& future) {
+  std::move(future).on_result([state, index](auto&& result) noexcept {
+    state->set(index, std::move(result));
+  });
+}
+
+template <typename State, typename... Futures, std::size_t... Indices>
+void subscribe_any(std::shared_ptr<State> const& state,
+                   std::index_sequence<Indices...>, Futures&&... futures) {
+  using Expand = int[];
+  (void)Expand{0, (subscribe_any(state, Indices, std::move(futures)), 0)...};
+}
+
+}  // namespace detail
+
+template <typename E, typename... Types>
+Future<std::tuple<Types...>, E> when_all(Future<Types, E>&&... futures) {
+  static_assert(sizeof...(Types) > 0U, "when_all needs at least one future");
+  Promise<std::tuple<Types...>, E> promise;
+  auto future = promise.get_future();
+  auto state = std::make_shared<detail::WhenAllState<E, Types...>>(
+      std::move(promise));
+  detail::subscribe_all(state, std::index_sequence_for<Types...>(),
+                        std::move(futures)...);
+  return future;
+}
+
+template <typename T, typename E>
+Future<std::vector<T>, E> when_all(std::vector<Future<T, E>>&& futures) {
+  Promise<std::vector<T>, E> promise;
+  auto future = promise.get_future();
+  if (futures.empty()) {
+    promise.set_value();
+    return future;
+  }
+  auto state = std::make_shared<detail::WhenAllVectorState<T, E>>(
+      futures.size(), std::move(promise));
+  for (std::size_t i = 0U; i < futures.size(); ++i) {
+    detail::subscribe_any(state, i, std::move(futures[i]));
+  }
+  return future;
+}
+
+template <typename T, typename E, typename... Rest>
+Future<T, E> when_any(Future<T, E>&& first, Rest&&... rest) {
+  static_assert(
+      detail::all_true<std::is_same<Rest, Future<T, E>>::value...>::value,
+      "when_any needs rvalue futures of the same type");
+  Promise<T, E> promise;
+  auto future = promise.get_future();
+  auto state = std::make_shared<detail::WhenAnyState<T, E>>(
+      1U + sizeof...(Rest), std::move(promise));
+  detail::subscribe_any(state, std::index_sequence_for<T, Rest...>(),
+                        std::move(first), std::move(rest)...);
+  return future;
+}
+
+template <typename T, typename E>
+Future<T, E> when_any(std::vector<Future<T, E>>&& futures) {
+  Promise<T, E> promise;
+  auto future = promise.get_future();
+  if (futures.empty()) {
+    promise.set_error(std::make_error_code(std::errc::invalid_argument));
+    return future;
+  }
+  auto state = std::make_shared<detail::WhenAnyState<T, E>>(
+      futures.size(), std::move(promise));
+  for (std::size_t i = 0U; i < futures.size(); ++i) {
+    detail::subscribe_any(state, i, std::move(futures[i]));
+  }
+  return future;
+}
+
+}  // namespace rms
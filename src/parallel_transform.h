@@ -0,0 +1,199 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#pragma once
+
+/*
+ * Transformation of a range on a thread pool:
+ *
+ *   std::vector<ValueOrError<Customer>> customers;
+ *   rms::parallel_transform(ids, get_customer, pool, customers);
+ *
+ * f: element -> ValueOrError<T, E> is called for every element of the random
+ * access range, results are written to out[i], out is resized to the size of
+ * the range. The range is split into chunks which are taken by the calling
+ * thread and by tasks posted to the pool, so the call makes progress even if
+ * the pool is busy (or the caller is one of its workers). f is called
+ * concurrently and must not throw. If posting to the pool throws, the
+ * exception is rethrown once the chunks are done by the caller and the
+ * tasks posted before.
+ *
+ * TransformMode::All transforms every element. TransformMode::FirstError sets
+ * a shared flag on the first failure, other workers stop at the next element
+ * and the rest of out is left empty. Both return the error of the failed
+ * element with the lowest index (among transformed ones), errors in out must
+ * be checked as any other results. Empty results hold neither value nor
+ * error, ValueOrErrorBatch::push_back() rejects them.
+ *
+ * Overload without out stops at the first error and returns all values or the
+ * error, as transform_collect() does.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "config.h"
+#include "thread_pool.h"
+#include "type_traits.h"
+#include "value_or_error.h"
+
+namespace rms {
+
+enum class TransformMode {
+  All,         // every element is transformed
+  FirstError,  // elements after the first observed error are skipped
+};
+
+namespace detail {
+
+// Each worker gets several chunks, so slow elements are balanced
+constexpr std::size_t ChunksPerThread = 4U;
+
+constexpr std::size_t NoFailure = std::numeric_limits<std::size_t>::max();
+
+// Shared by the caller and posted tasks. Tasks keep it alive, since they may
+// start after the caller has returned and then find no chunks left.
+struct TransformState {
+  explicit TransformState(std::size_t chunk_count) : chunks(chunk_count) {}
+
+  std::size_t const chunks;
+  std::atomic<std::size_t> next{0U};
+  std::atomic<bool> stopped{false};
+  std::atomic<std::size_t> failed{NoFailure};
+  std::mutex mutex;
+  std::condition_variable finished;
+  std::size_t done = 0U;  // guarded by mutex
+};
+
+inline void note_failure(std::atomic<std::size_t>& failed, std::size_t index) {
+  auto current = failed.load(std::memory_order_relaxed);
+  while (index < current &&
+         !failed.compare_exchange_weak(current, index,
+                                       std::memory_order_relaxed)) {
+  }
+}
+
+// Body is touched only for claimed chunks, while the caller waits for them
+template <typename Body>
+void run_chunks(TransformState& state, Body& body) {
+  for (;;) {
+    auto const chunk = state.next.fetch_add(1U, std::memory_order_relaxed);
+    if (chunk >= state.chunks) {
+      return;
+    }
+    body(chunk);
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (++state.done == state.chunks) {
+      state.finished.notify_all();
+    }
+  }
+}
+
+}  // namespace detail
+
+template <typename Range, typename F,
+          typename Result = decay_t<invoke_result_t<
+              F&, decltype(*std::begin(std::declval<Range&>()))>>,
+          typename E = typename Result::error_type>
+ValueOrError<void, E> parallel_transform(
+    Range&& range, F&& f, ThreadPool& pool, std::vector<Result>& out,
+    TransformMode mode = TransformMode::All) {
+  static_assert(is_value_or_error<Result>::value,
+                "F must return an ValueOrError");
+  using std::begin;
+  using std::end;
+  auto const first = begin(range);
+  using Category =
+      typename std::iterator_traits<decltype(first)>::iterator_category;
+  static_assert(
+      std::is_base_of<std::random_access_iterator_tag, Category>::value,
+      "Range must be random access");
+
+  auto const size = static_cast<std::size_t>(std::distance(first, end(range)));
+  out.clear();
+  out.resize(size);
+  if (size == 0U) {
+    return {};
+  }
+
+  auto const chunks =
+      std::min(size, (pool.size() + 1U) * detail::ChunksPerThread);
+  auto state = std::make_shared<detail::TransformState>(chunks);
+  auto const stop_on_error = mode == TransformMode::FirstError;
+  auto body = [&](std::size_t chunk) {
+    auto const last = (chunk + 1U) * size / chunks;
+    for (auto i = chunk * size / chunks; i < last; ++i) {
+      if (stop_on_error && state->stopped.load(std::memory_order_relaxed)) {
+        return;
+      }
+      out[i] = rms::invoke(f, first[static_cast<std::ptrdiff_t>(i)]);
+      if (VOE_UNLIKELY(!out[i].has_value())) {
+        detail::note_failure(state->failed, i);
+        state->stopped.store(true, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  auto const helpers = std::min(pool.size(), chunks - 1U);
+  std::exception_ptr post_failure;
+  try {
+    for (std::size_t i = 0U; i < helpers; ++i) {
+      pool.post([state, &body] { detail::run_chunks(*state, body); });
+    }
+  } catch (...) {
+    // Tasks posted so far refer to body, the error waits for them
+    post_failure = std::current_exception();
+  }
+  detail::run_chunks(*state, body);
+  {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(
+        lock, [&state] { return state->done == state->chunks; });
+  }
+  if (VOE_UNLIKELY(post_failure != nullptr)) {
+    std::rethrow_exception(post_failure);
+  }
+
+  auto const failed = state->failed.load(std::memory_order_relaxed);
+  if (VOE_UNLIKELY(failed != detail::NoFailure)) {
+    return detail::propagate_error<ValueOrError<void, E>>(out[failed].error());
+  }
+  return {};
+}
+
+template <typename Range, typename F,
+          typename Result = decay_t<invoke_result_t<
+              F&, decltype(*std::begin(std::declval<Range&>()))>>>
+ValueOrError<std::vector<typename Result::value_type>,
+             typename Result::error_type>
+parallel_transform(Range&& range, F&& f, ThreadPool& pool) {
+  using Values = std::vector<typename Result::value_type>;
+  using Collected = ValueOrError<Values, typename Result::error_type>;
+  std::vector<Result> results;
+  auto status = parallel_transform(std::forward<Range>(range),
+                                   std::forward<F>(f), pool, results,
+                                   TransformMode::FirstError);
+  if (VOE_UNLIKELY(!status)) {
+    // Only the first error is reported
+    for (auto& result : results) {
+      result.ignore();
+    }
+    return detail::propagate_error<Collected>(status.error());
+  }
+  Values values;
+  values.reserve(results.size());
+  for (auto& result : results) {
+    values.push_back(result.extract());
+  }
+  return Collected(in_place, std::move(values));
+}
+
+}  // namespace rms
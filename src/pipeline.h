@@ -0,0 +1,190 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#pragma once
+
+/*
+ * Lazy pipeline over ValueOrError:
+ *
+ *   using namespace rms::pipeline;
+ *   auto result = (pipe(text) | then(parse) | map(scale) | then(save)).run();
+ *
+ * Stages are composed at compile time and run only by run(). Values are
+ * passed from stage to stage as plain rvalues, so only the result of run()
+ * is a ValueOrError. then(f) stages still get the ValueOrError returned by f,
+ * its value is moved to the next stage. The first error stops the pipeline.
+ *
+ * Pipeline refers to an lvalue source, which must outlive run(). An rvalue
+ * source is moved into the pipeline, so it can be built and run later.
+ */
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "config.h"
+#include "type_traits.h"
+#include "value_or_error.h"
+
+namespace rms {
+namespace pipeline {
+
+// Stage with f: T -> ValueOrError<U>
+template <typename F>
+struct ThenStage {
+  F f;
+};
+
+// Stage with f: T -> U
+template <typename F>
+struct MapStage {
+  F f;
+};
+
+template <typename F>
+ThenStage<decay_t<F>> then(F&& f) {
+  return {std::forward<F>(f)};
+}
+
+template <typename F>
+MapStage<decay_t<F>> map(F&& f) {
+  return {std::forward<F>(f)};
+}
+
+namespace detail {
+
+// Type of the value produced by the stage from argument of type Arg
+template <typename Stage, typename Arg>
+struct stage_output;
+
+template <typename F, typename Arg>
+struct stage_output<ThenStage<F>, Arg> {
+  using result = invoke_result_t<F&, Arg>;
+  static_assert(is_value_or_error<result>::value,
+                "then() stage must return an ValueOrError");
+  using type = typename decay_t<result>::value_type;
+  static_assert(!std::is_void<type>::value,
+                "then() stage must return a value to pass further");
+};
+
+template <typename F, typename Arg>
+struct stage_output<MapStage<F>, Arg> {
+  using type = decay_t<invoke_result_t<F&, Arg>>;
+  static_assert(!std::is_void<type>::value,
+                "map() stage must return a value to pass further");
+};
+
+// Type of the value after all stages
+template <typename Arg, typename... Stages>
+struct pipeline_output {
+  using type = decay_t<Arg>;
+};
+
+template <typename Arg, typename Stage, typename... Rest>
+struct pipeline_output<Arg, Stage, Rest...> {
+  using type = typename pipeline_output<
+      typename stage_output<Stage, Arg>::type&&, Rest...>::type;
+};
+
+// Overloads call each other, so all of them are declared first
+template <typename Result, typename Arg, typename F, typename... Rest>
+Result run_stages(Arg&& arg, ThenStage<F>& stage, Rest&... rest);
+
+template <typename Result, typename Arg, typename F, typename... Rest>
+Result run_stages(Arg&& arg, MapStage<F>& stage, Rest&... rest);
+
+template <typename Result, typename Arg>
+Result run_stages(Arg&& arg) {
+  return Result(in_place, std::forward<Arg>(arg));
+}
+
+template <typename Result, typename Arg, typename F, typename... Rest>
+Result run_stages(Arg&& arg, ThenStage<F>& stage, Rest&... rest) {
+  auto result = rms::invoke(stage.f, std::forward<Arg>(arg));
+  if (VOE_UNLIKELY(!result)) {
+    return rms::detail::propagate_error<Result>(result.error());
+  }
+  return run_stages<Result>(std::move(result.extract()), rest...);
+}
+
+template <typename Result, typename Arg, typename F, typename... Rest>
+Result run_stages(Arg&& arg, MapStage<F>& stage, Rest&... rest) {
+  return run_stages<Result>(rms::invoke(stage.f, std::forward<Arg>(arg)),
+                            rest...);
+}
+
+}  // namespace detail
+
+// Source is a reference to lvalue ValueOrError<T, E> or ValueOrError<T, E>
+// owned by the pipeline. The value of lvalue source is passed to the first
+// stage by lvalue reference, the value of owned source is moved.
+template <typename Source, typename... Stages>
+class Pipeline {
+ public:
+  using source_type = decay_t<Source>;
+  using source_value_type = typename source_type::value_type;
+  using source_argument_type = typename std::conditional<
+      std::is_lvalue_reference<Source>::value,
+      decltype(std::declval<Source>().value()), source_value_type&&>::type;
+  using value_type = typename detail::pipeline_output<source_argument_type,
+                                                      Stages...>::type;
+  using error_type = typename source_type::error_type;
+  using result_type = ValueOrError<value_type, error_type>;
+
+  Pipeline(Source source, std::tuple<Stages...>&& stages)
+      : m_source(std::forward<Source>(source)), m_stages(std::move(stages)) {}
+
+  template <typename F>
+  Pipeline<Source, Stages..., ThenStage<F>> operator|(
+      ThenStage<F> stage) && {
+    return append(std::move(stage));
+  }
+
+  template <typename F>
+  Pipeline<Source, Stages..., MapStage<F>> operator|(MapStage<F> stage) && {
+    return append(std::move(stage));
+  }
+
+  // Runs all stages. Pipeline can't be used after that.
+  result_type run() && {
+    return run(std::index_sequence_for<Stages...>());
+  }
+
+ private:
+  template <typename Stage>
+  Pipeline<Source, Stages..., Stage> append(Stage&& stage) {
+    return {std::forward<Source>(m_source),
+            std::tuple_cat(std::move(m_stages),
+                           std::make_tuple(std::forward<Stage>(stage)))};
+  }
+
+  template <std::size_t... Indices>
+  result_type run(std::index_sequence<Indices...>) {
+    if (VOE_UNLIKELY(!m_source)) {
+      return rms::detail::propagate_error<result_type>(m_source.error());
+    }
+    return detail::run_stages<result_type>(
+        static_cast<source_argument_type>(m_source.value()),
+        std::get<Indices>(m_stages)...);
+  }
+
+  Source m_source;
+  std::tuple<Stages...> m_stages;
+};
+
+template <typename T, typename E>
+Pipeline<ValueOrError<T, E>&> pipe(ValueOrError<T, E>& source) {
+  return {source, std::tuple<>()};
+}
+
+template <typename T, typename E>
+Pipeline<ValueOrError<T, E> const&> pipe(ValueOrError<T, E> const& source) {
+  return {source, std::tuple<>()};
+}
+
+template <typename T, typename E>
+Pipeline<ValueOrError<T, E>> pipe(ValueOrError<T, E>&& source) {
+  return {std::move(source), std::tuple<>()};
+}
+
+}  // namespace pipeline
+}  // namespace rms
@@ -0,0 +1,358 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#pragma once
+
+/*
+ * Lazily started coroutine with ValueOrError result (C++20, VOE_COROUTINES):
+ *
+ *   rms::Task<bool> is_auth_customer(rms::ThreadPool& pool, Db& db) {
+ *     co_await rms::schedule(pool);
+ *     auto customer = co_await db.get_active_customer();  // Task<string>
+ *     co_return co_await db.is_auth(customer);            // ValueOrError
+ *   }
+ *
+ *   ValueOrError<bool> auth = rms::start(is_auth_customer(pool, db)).get();
+ *
+ * A Task does nothing until it is awaited or started. Inside a Task, both
+ * co_await of another Task and of ValueOrError give the value, and an error
+ * finishes the awaiting Task with that error, as in coroutine.h. Any other
+ * coroutine which awaits a Task gets the whole ValueOrError<T, E>.
+ *
+ * Awaiting starts the awaited Task by symmetric transfer and its completion
+ * resumes the awaiting one the same way, so chains of any depth run in
+ * constant stack. That depends on the transfer being compiled to a tail
+ * call: GCC needs -foptimize-sibling-calls (on at -O2, the VOE_COROUTINES
+ * CMake option adds it), and sanitizer builds may not do it at all. An
+ * error walks the chain of Tasks which wait for values and resumes the first
+ * one which waits for the result, the Tasks in between are not resumed.
+ * Frames come from FramePool.
+ *
+ * schedule(executor) resumes the Task on the executor (ThreadPool, or
+ * InlineExecutor to stay on the calling thread). start(task) runs the Task
+ * on the calling thread until it suspends and gives a Future of its result.
+ * Exceptions are rethrown to the awaiting Task. An exception which leaves a
+ * started Task breaks the promise of the Future.
+ *
+ * GCC 12 miscompiles a lazily started coroutine with co_await in the
+ * condition of an if statement: it never completes. The check of
+ * coroutine.h covers it, so such compilers are refused by CMake.
+ */
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <system_error>
+#include <utility>
+
+#include "config.h"
+#include "coroutine.h"
+#include "future.h"
+#include "value_or_error.h"
+
+namespace rms {
+
+template <typename T, typename E = std::error_code>
+class Task;
+
+namespace detail {
+
+class TaskPromiseBase {
+ public:
+  static void* operator new(std::size_t size) {
+    return FramePool::allocate(size);
+  }
+
+  static void operator delete(void* frame, std::size_t size) noexcept {
+    FramePool::deallocate(frame, size);
+  }
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+
+  void unhandled_exception() noexcept {
+    m_exception = std::current_exception();
+  }
+
+  // Awaited by a Task which waits for the value, not for the result
+  void set_parent(TaskPromiseBase& parent) noexcept { m_parent = &parent; }
+
+  void set_continuation(std::coroutine_handle<> continuation) noexcept {
+    m_continuation = continuation;
+  }
+
+  void rethrow_if_failed() const {
+    if (VOE_UNLIKELY(m_exception != nullptr)) {
+      std::rethrow_exception(m_exception);
+    }
+  }
+
+  // Only the first Task of the chain which waits for the result gets the
+  // error. Returns the coroutine which waits for it.
+  VOE_COLD std::coroutine_handle<> propagate(std::error_code error,
+                                             std::coroutine_handle<> = {}) {
+    auto* promise = this;
+    while (promise->m_parent != nullptr) {
+      promise = promise->m_parent;
+    }
+    promise->set_error(error);
+    return promise->m_continuation;
+  }
+
+ protected:
+  TaskPromiseBase() = default;
+  ~TaskPromiseBase() = default;
+
+  virtual void set_error(std::error_code error) = 0;
+
+  TaskPromiseBase* m_parent = nullptr;
+  std::coroutine_handle<> m_continuation = std::noop_coroutine();
+  std::exception_ptr m_exception;
+};
+
+template <typename T, typename E>
+class TaskPromise final : public TaskPromiseBase {
+ public:
+  using result_type = ValueOrError<T, E>;
+  using handle_type = std::coroutine_handle<TaskPromise>;
+
+  class FinalAwaiter {
+   public:
+    explicit FinalAwaiter(TaskPromise& promise) noexcept
+        : m_promise(promise) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<>) noexcept {
+      return m_promise.complete();
+    }
+
+    void await_resume() const noexcept {}
+
+   private:
+    TaskPromise& m_promise;
+  };
+
+  Task<T, E> get_return_object() noexcept {
+    return Task<T, E>(handle_type::from_promise(*this));
+  }
+
+  FinalAwaiter final_suspend() noexcept { return FinalAwaiter(*this); }
+
+  void return_value(result_type&& result) { m_result = std::move(result); }
+
+  template <typename U, typename OtherE>
+  ExtractAwaiter<U, OtherE, TaskPromiseBase> await_transform(
+      ValueOrError<U, OtherE>&& result) noexcept {
+    return {result, *this};
+  }
+
+  template <typename U, typename OtherE>
+  BorrowAwaiter<ValueOrError<U, OtherE>, TaskPromiseBase> await_transform(
+      ValueOrError<U, OtherE>& result) noexcept {
+    return {result, *this};
+  }
+
+  template <typename U, typename OtherE>
+  BorrowAwaiter<ValueOrError<U, OtherE> const, TaskPromiseBase>
+  await_transform(ValueOrError<U, OtherE> const& result) noexcept {
+    return {result, *this};
+  }
+
+  template <typename U, typename OtherE>
+  auto await_transform(Task<U, OtherE>&& task) noexcept {
+    return std::move(task).await_value(*this);
+  }
+
+  template <typename Awaitable>
+  Awaitable&& await_transform(Awaitable&& awaitable) noexcept {
+    return std::forward<Awaitable>(awaitable);
+  }
+
+  result_type& result() noexcept { return m_result; }
+
+ private:
+  std::coroutine_handle<> complete() noexcept {
+    if (VOE_UNLIKELY(m_parent != nullptr && m_exception == nullptr &&
+                     !m_result.has_value())) {
+      return propagate(m_result.error());
+    }
+    return m_continuation;
+  }
+
+  VOE_COLD void set_error(std::error_code error) override {
+    m_result = propagate_error<result_type>(error);
+  }
+
+  result_type m_result;
+};
+
+// Gives the result of the awaited Task
+template <typename T, typename E>
+class TaskResultAwaiter {
+ public:
+  using handle_type = std::coroutine_handle<TaskPromise<T, E>>;
+
+  explicit TaskResultAwaiter(handle_type handle) noexcept : m_handle(handle) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  std::coroutine_handle<> await_suspend(
+      std::coroutine_handle<> awaiting) noexcept {
+    m_handle.promise().set_continuation(awaiting);
+    return m_handle;
+  }
+
+  ValueOrError<T, E> await_resume() {
+    m_handle.promise().rethrow_if_failed();
+    return std::move(m_handle.promise().result());
+  }
+
+ protected:
+  handle_type m_handle;
+};
+
+// Gives the value of the awaited Task, its error skips the awaiting Task
+template <typename T, typename E>
+class TaskValueAwaiter : public TaskResultAwaiter<T, E> {
+ public:
+  TaskValueAwaiter(typename TaskResultAwaiter<T, E>::handle_type handle,
+                   TaskPromiseBase& parent) noexcept
+      : TaskResultAwaiter<T, E>(handle), m_parent(parent) {}
+
+  std::coroutine_handle<> await_suspend(
+      std::coroutine_handle<> awaiting) noexcept {
+    this->m_handle.promise().set_parent(m_parent);
+    return TaskResultAwaiter<T, E>::await_suspend(awaiting);
+  }
+
+  T await_resume() {
+    this->m_handle.promise().rethrow_if_failed();
+    return this->m_handle.promise().result().extract();
+  }
+
+ private:
+  TaskPromiseBase& m_parent;
+};
+
+// Started and owned by nobody, the frame is destroyed on completion
+class DetachedTask {
+ public:
+  class promise_type {
+   public:
+    static void* operator new(std::size_t size) {
+      return FramePool::allocate(size);
+    }
+
+    static void operator delete(void* frame, std::size_t size) noexcept {
+      FramePool::deallocate(frame, size);
+    }
+
+    DetachedTask get_return_object() const noexcept { return {}; }
+
+    std::suspend_never initial_suspend() const noexcept { return {}; }
+
+    std::suspend_never final_suspend() const noexcept { return {}; }
+
+    void return_void() const noexcept {}
+
+    // The promise of the Future is broken by destruction of the frame
+    void unhandled_exception() const noexcept {}
+  };
+};
+
+template <typename T, typename E>
+DetachedTask run_detached(Task<T, E> task, Promise<T, E> promise) {
+  promise.set_result(co_await std::move(task));
+}
+
+template <typename Executor>
+class ScheduleAwaiter {
+ public:
+  explicit ScheduleAwaiter(Executor& executor) noexcept
+      : m_executor(executor) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    m_executor.post([handle] { handle.resume(); });
+  }
+
+  void await_resume() const noexcept {}
+
+ private:
+  Executor& m_executor;
+};
+
+}  // namespace detail
+
+template <typename T, typename E>
+class VOE_NODISCARD Task {
+ public:
+  using promise_type = detail::TaskPromise<T, E>;
+  using value_type = T;
+  using error_type = E;
+  using result_type = ValueOrError<T, E>;
+
+  Task() noexcept = default;
+
+  Task(Task&& other) noexcept
+      : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      reset();
+      m_handle = std::exchange(other.m_handle, nullptr);
+    }
+    return *this;
+  }
+
+  Task(Task const&) = delete;
+  Task& operator=(Task const&) = delete;
+
+  ~Task() { reset(); }
+
+  // False for default constructed and moved from tasks
+  bool valid() const noexcept { return static_cast<bool>(m_handle); }
+
+  // Awaited by coroutines other than Task
+  detail::TaskResultAwaiter<T, E> operator co_await() && noexcept {
+    return detail::TaskResultAwaiter<T, E>(m_handle);
+  }
+
+ private:
+  template <typename U, typename OtherE>
+  friend class detail::TaskPromise;
+
+  using handle_type = std::coroutine_handle<promise_type>;
+
+  explicit Task(handle_type handle) noexcept : m_handle(handle) {}
+
+  detail::TaskValueAwaiter<T, E> await_value(
+      detail::TaskPromiseBase& parent) && noexcept {
+    return detail::TaskValueAwaiter<T, E>(m_handle, parent);
+  }
+
+  void reset() noexcept {
+    if (m_handle) {
+      m_handle.destroy();
+      m_handle = nullptr;
+    }
+  }
+
+  handle_type m_handle;
+};
+
+// Resumes the awaiting coroutine on the executor
+template <typename Executor>
+detail::ScheduleAwaiter<Executor> schedule(Executor& executor) noexcept {
+  return detail::ScheduleAwaiter<Executor>(executor);
+}
+
+// Runs the task on the calling thread until it suspends
+template <typename T, typename E>
+Future<T, E> start(Task<T, E>&& task) {
+  Promise<T, E> promise;
+  auto future = promise.get_future();
+  detail::run_detached(std::move(task), std::move(promise));
+  return future;
+}
+
+}  // namespace rms
@@ -0,0 +1,304 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#pragma once
+
+/*
+ * Work-stealing pool of threads which run posted tasks:
+ *
+ *   rms::ThreadPool pool(4U);
+ *   pool.post([] { ... });
+ *   pool.post([] { return db.get_active_customer(); },
+ *             [](ValueOrError<std::string>&& customer) { ... });
+ *
+ * Every worker has its own Chase-Lev deque. Tasks posted from a worker go to
+ * the bottom of its deque and are run LIFO, so continuations run while data
+ * is hot in cache. Tasks posted from other threads go to the global injection
+ * queue (lock-free stack), a worker takes all of them at once into its deque.
+ * Workers without tasks steal from the top of other deques, then spin for a
+ * while and park on a condition variable. Posting wakes a parked worker only
+ * if there is one, so the hot path takes no locks.
+ *
+ * There is no order of execution. A task which returns a result (e.g.
+ * ValueOrError<T>) must be posted with a handler which takes the result, so
+ * errors can't be dropped silently. Destructor runs tasks which are already
+ * posted and joins the threads. Tasks must not throw.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "type_traits.h"
+#include "work_stealing_deque.h"
+
+namespace rms {
+namespace detail {
+
+struct PoolTask {
+  PoolTask() = default;
+  PoolTask(PoolTask const&) = delete;
+  PoolTask& operator=(PoolTask const&) = delete;
+  virtual ~PoolTask() = default;
+
+  virtual void run() = 0;
+
+  PoolTask* next = nullptr;  // link in the injection queue
+};
+
+template <typename F>
+class PoolTaskImpl final : public PoolTask {
+ public:
+  template <typename U>
+  explicit PoolTaskImpl(U&& f) : m_f(std::forward<U>(f)) {}
+
+  void run() override { m_f(); }
+
+ private:
+  F m_f;
+};
+
+template <typename F, typename Handler>
+struct HandledTask {
+  void operator()() { rms::invoke(handler, rms::invoke(f)); }
+
+  F f;
+  Handler handler;
+};
+
+// Multiple producers push, consumers take all tasks at once, so there is no
+// ABA problem. Tasks are taken newest first.
+class InjectionQueue {
+ public:
+  void push(PoolTask* task) noexcept {
+    auto* head = m_head.load(std::memory_order_relaxed);
+    do {
+      task->next = head;
+    } while (!m_head.compare_exchange_weak(head, task,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed));
+  }
+
+  PoolTask* take_all() noexcept {
+    if (m_head.load(std::memory_order_relaxed) == nullptr) {
+      return nullptr;
+    }
+    return m_head.exchange(nullptr, std::memory_order_acquire);
+  }
+
+  bool empty() const noexcept {
+    return m_head.load(std::memory_order_acquire) == nullptr;
+  }
+
+ private:
+  std::atomic<PoolTask*> m_head{nullptr};
+};
+
+}  // namespace detail
+
+class ThreadPool {
+ public:
+  // Number of threads used by default: one per hardware thread
+  static std::size_t default_concurrency() noexcept {
+    return std::max<std::size_t>(1U, std::thread::hardware_concurrency());
+  }
+
+  explicit ThreadPool(std::size_t threads = default_concurrency()) {
+    threads = std::max<std::size_t>(1U, threads);
+    m_workers.reserve(threads);
+    for (std::size_t i = 0U; i < threads; ++i) {
+      m_workers.emplace_back(new Worker(*this, i));
+    }
+    m_threads.reserve(threads);
+    for (auto& worker : m_workers) {
+      auto* current = worker.get();
+      m_threads.emplace_back([this, current] { run(*current); });
+    }
+  }
+
+  ThreadPool(ThreadPool const&) = delete;
+  ThreadPool& operator=(ThreadPool const&) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stopped = true;
+      ++m_epoch;
+    }
+    m_wake.notify_all();
+    for (auto& thread : m_threads) {
+      thread.join();
+    }
+  }
+
+  std::size_t size() const noexcept { return m_workers.size(); }
+
+  // True if called from one of the workers of the pool
+  bool in_worker() const noexcept {
+    auto const* worker = current_worker();
+    return worker != nullptr && &worker->pool == this;
+  }
+
+  template <typename F>
+  void post(F&& f) {
+    static_assert(std::is_void<invoke_result_t<decay_t<F>&>>::value,
+                  "Result of the task must be passed to a handler");
+    push(new detail::PoolTaskImpl<decay_t<F>>(std::forward<F>(f)));
+  }
+
+  // Runs handler(f()) on a worker
+  template <typename F, typename Handler>
+  void post(F&& f, Handler&& handler) {
+    post(detail::HandledTask<decay_t<F>, decay_t<Handler>>{
+        std::forward<F>(f), std::forward<Handler>(handler)});
+  }
+
+ private:
+  // Workers spin this many rounds looking for tasks before parking
+  static constexpr int SpinRounds = 64;
+
+  struct Worker {
+    Worker(ThreadPool& owner, std::size_t index)
+        : pool(owner),
+          seed(static_cast<std::uint32_t>(index) * 2654435761U + 1U) {}
+
+    ThreadPool& pool;
+    std::uint32_t seed;  // of victim selection
+    detail::WorkStealingDeque<detail::PoolTask> tasks;
+  };
+
+  static Worker*& current_worker() noexcept {
+    static thread_local Worker* worker = nullptr;
+    return worker;
+  }
+
+  void push(detail::PoolTask* task) {
+    auto* worker = current_worker();
+    if (worker != nullptr && &worker->pool == this) {
+      worker->tasks.push(task);
+    } else {
+      m_injected.push(task);
+    }
+    wake_one();
+  }
+
+  void wake_one() {
+    // Pairs with the fence in park(): either the parking worker sees the task
+    // or the task owner sees the worker
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleeping.load(std::memory_order_relaxed) == 0U) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      ++m_epoch;
+    }
+    m_wake.notify_one();
+  }
+
+  void run(Worker& worker) {
+    current_worker() = &worker;
+    for (;;) {
+      if (auto* task = find_task(worker)) {
+        execute(task);
+      } else if (!park()) {
+        return;
+      }
+    }
+  }
+
+  static void execute(detail::PoolTask* task) {
+    task->run();
+    delete task;
+  }
+
+  detail::PoolTask* find_task(Worker& worker) {
+    if (auto* task = worker.tasks.pop()) {
+      return task;
+    }
+    if (auto* injected = m_injected.take_all()) {
+      // Newest first, so the oldest one is popped first
+      bool many = injected->next != nullptr;
+      while (injected != nullptr) {
+        auto* next = injected->next;
+        worker.tasks.push(injected);
+        injected = next;
+      }
+      if (many) {
+        wake_one();
+      }
+      return worker.tasks.pop();
+    }
+    return steal(worker);
+  }
+
+  detail::PoolTask* steal(Worker& worker) {
+    auto const count = m_workers.size();
+    if (count < 2U) {
+      return nullptr;
+    }
+    // xorshift
+    worker.seed ^= worker.seed << 13U;
+    worker.seed ^= worker.seed >> 17U;
+    worker.seed ^= worker.seed << 5U;
+    auto const start = worker.seed % count;
+    for (std::size_t i = 0U; i < count; ++i) {
+      auto& victim = *m_workers[(start + i) % count];
+      if (&victim == &worker) {
+        continue;
+      }
+      if (auto* task = victim.tasks.steal()) {
+        return task;
+      }
+    }
+    return nullptr;
+  }
+
+  bool has_work() const noexcept {
+    if (!m_injected.empty()) {
+      return true;
+    }
+    for (auto const& worker : m_workers) {
+      if (!worker->tasks.empty()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Returns false if the pool is stopped and there is nothing to run
+  bool park() {
+    for (int i = 0; i < SpinRounds; ++i) {
+      if (has_work()) {
+        return true;
+      }
+      std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto const epoch = m_epoch;
+    m_sleeping.fetch_add(1U, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!has_work() && !m_stopped) {
+      m_wake.wait(lock, [this, epoch] { return m_epoch != epoch; });
+    }
+    m_sleeping.fetch_sub(1U, std::memory_order_relaxed);
+    return !m_stopped || has_work();
+  }
+
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  detail::InjectionQueue m_injected;
+  std::atomic<std::size_t> m_sleeping{0U};
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::uint64_t m_epoch = 0U;  // guarded by m_mutex
+  bool m_stopped = false;      // guarded by m_mutex
+  std::vector<std::thread> m_threads;
+};
+
+}  // namespace rms
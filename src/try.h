@@ -1,6 +1,8 @@
 // Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
 #pragma once
 
+#include "config.h"
+
 #define VOE_TRY_GLUE2(x, y) x##y
 #define VOE_TRY_GLUE(x, y) VOE_TRY_GLUE2(x, y)
 #define VOE_TRY_UNIQUE_NAME \
@@ -8,10 +10,20 @@
 
 #define VOE_TRY_EXTRACT_IMPL(unique, v, ...) \
   auto&& unique = (__VA_ARGS__);             \
-  if (!(unique).has_value()) {               \
+  if (VOE_UNLIKELY(!(unique).has_value())) { \
     return (unique).error();                 \
   }                                          \
   auto&& v = std::move((unique).extract());
 
 #define VOE_TRY_EXTRACT(v, ...) \
   VOE_TRY_EXTRACT_IMPL(VOE_TRY_UNIQUE_NAME, v, __VA_ARGS__)
+
+// Propagates error of the result, value (if any) is not used.
+// Intended for ValueOrError<void>.
+#define VOE_TRY_IMPL(unique, ...)            \
+  auto&& unique = (__VA_ARGS__);             \
+  if (VOE_UNLIKELY(!(unique).has_value())) { \
+    return (unique).error();                 \
+  }
+
+#define VOE_TRY(...) VOE_TRY_IMPL(VOE_TRY_UNIQUE_NAME, __VA_ARGS__)
@@ -1,7 +1,10 @@
 // Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
 #pragma once
 
+#include <cstddef>
 #include <functional>
+#include <ostream>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 
@@ -97,9 +100,11 @@ struct invoke_result_impl;
 
 template <class F, class... Us>
 struct invoke_result_impl<
-    F, decltype(invoke(std::declval<F>(), std::declval<Us>()...), void()),
+    F,
+    decltype(rms::invoke(std::declval<F>(), std::declval<Us>()...), void()),
     Us...> {
-  using type = decltype(invoke(std::declval<F>(), std::declval<Us>()...));
+  using type =
+      decltype(rms::invoke(std::declval<F>(), std::declval<Us>()...));
 };
 
 template <class F, class... Us>
@@ -108,4 +113,17 @@ using invoke_result = invoke_result_impl<F, void, Us...>;
 template <class F, class... Us>
 using invoke_result_t = typename invoke_result<F, Us...>::type;
 
+// std::is_invocable from C++17
+template <class F, class, class... Us>
+struct is_invocable_impl : std::false_type {};
+
+template <class F, class... Us>
+struct is_invocable_impl<
+    F,
+    decltype(rms::invoke(std::declval<F>(), std::declval<Us>()...), void()),
+    Us...> : std::true_type {};
+
+template <class F, class... Us>
+using is_invocable = is_invocable_impl<F, void, Us...>;
+
 }  // namespace rms
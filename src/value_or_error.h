@@ -11,13 +11,21 @@
 // https://www.youtube.com/watch?v=GC4cp4U2f2E
 #pragma once
 
-#include <boost/variant.hpp>
 #include <cassert>
+#include <cstdint>
+#include <cstdlib>
 #include <functional>
+#include <initializer_list>
+#include <memory>
+#include <new>
 #include <ostream>
+#include <sstream>
+#include <stdexcept>
 #include <system_error>
 #include <type_traits>
 
+#include "config.h"
+#include "error_category.h"
 #include "type_traits.h"
 
 namespace rms {
@@ -30,126 +38,705 @@ struct is_value_or_error_impl : std::false_type {};
 template <typename T>
 using is_value_or_error = is_value_or_error_impl<decay_t<T>>;
 
+// std::in_place_t from C++17. Requests construction of the value directly
+// inside ValueOrError.
+struct in_place_t {
+  explicit in_place_t() = default;
+};
+constexpr in_place_t in_place{};
+
+namespace detail {
+
+// Single state byte of ValueOrError. Two low bits tell which member of the
+// storage union is alive, the rest are flags.
+enum State : std::uint8_t {
+  StateEmpty = 0x0,
+  StateValue = 0x1,
+  StateError = 0x2,
+  StateKindMask = 0x3,
+  // Value was moved out with extract(). Moved-from value is still alive.
+  StateExtracted = 0x4,
+  // Error was checked (or explicitly ignored) by the user. Tracked only when
+  // VOE_RUNTIME_CHECKS is on.
+  StateHandled = 0x8,
+};
+
+// Whether U is a value for ValueOrError rather than an error or tag
+template <typename U, typename E>
+struct is_value_argument
+    : std::integral_constant<
+          bool, !is_value_or_error<U>::value &&
+                    !std::is_same<decay_t<U>, in_place_t>::value &&
+                    !std::is_same<decay_t<U>, std::error_code>::value &&
+                    !std::is_same<decay_t<U>, E>::value &&
+                    !std::is_error_code_enum<decay_t<U>>::value &&
+                    !std::is_error_condition_enum<decay_t<U>>::value> {};
+
+namespace swap_adl {
+
+using std::swap;
+
+// std::is_nothrow_swappable from C++17
 template <typename T>
-class ValueOrError {
+struct is_nothrow_swappable
+    : std::integral_constant<bool, noexcept(swap(std::declval<T&>(),
+                                                 std::declval<T&>()))> {};
+
+}  // namespace swap_adl
+
+using swap_adl::is_nothrow_swappable;
+
+// Stored in place of the value by ValueOrError<void>
+struct Unit {};
+
+#if VOE_COROUTINES
+// Requests the result object of a coroutine (see coroutine.h)
+struct coroutine_result_t {
+  explicit coroutine_result_t() = default;
+};
+#endif
+
+// Error paths are out of line and cold, so the happy path of the caller stays
+// compact and falls through.
+[[noreturn]] VOE_COLD inline void abort_unhandled_error() noexcept {
+  std::abort();
+}
+
+[[noreturn]] VOE_COLD inline void throw_bad_value_access(std::uint8_t kind) {
+  if (kind == StateError) {
+    throw std::logic_error("Cannot get value. Error is already stored.");
+  }
+  throw std::logic_error("Value is not stored.");
+}
+
+template <typename E>
+VOE_COLD E error_from_code(std::error_code error) {
+  return E(error);
+}
+
+template <typename E, typename ErrorEnum>
+VOE_COLD E error_from_enum(ErrorEnum error) {
+  return E(make_error_code(error));
+}
+
+// Builds the error result of a failed step of a chain
+template <typename Ret>
+VOE_COLD Ret propagate_error(std::error_code error) {
+  return Ret(error);
+}
+
+// Whether U can be stored as the error of ValueOrError<T, E>
+template <typename U, typename E>
+struct is_error_argument
+    : std::integral_constant<
+          bool, std::is_same<decay_t<U>, std::error_code>::value ||
+                    std::is_same<decay_t<U>, E>::value ||
+                    std::is_error_code_enum<decay_t<U>>::value ||
+                    std::is_error_condition_enum<decay_t<U>>::value> {};
+
+// Calls f and wraps its result into Ret. Result of void f is a success.
+template <typename Ret, typename F, typename... ArgTypes>
+Ret invoke_wrapped(std::true_type /*is_void*/, F&& f, ArgTypes&&... args) {
+  rms::invoke(std::forward<F>(f), std::forward<ArgTypes>(args)...);
+  return Ret();
+}
+
+template <typename Ret, typename F, typename... ArgTypes>
+Ret invoke_wrapped(std::false_type /*is_void*/, F&& f, ArgTypes&&... args) {
+  return Ret(in_place,
+             rms::invoke(std::forward<F>(f), std::forward<ArgTypes>(args)...));
+}
+
+// Error result of map_error()
+template <typename Ret, typename F>
+VOE_COLD Ret mapped_error(F&& f, std::error_code error) {
+  using Error = decltype(rms::invoke(std::forward<F>(f), error));
+  static_assert(
+      is_error_argument<Error, typename Ret::error_type>::value,
+      "F must return std::error_code, an error enum or the error type");
+  return Ret(rms::invoke(std::forward<F>(f), error));
+}
+
+// Result of or_else(). Void f only observes the error, so it is kept.
+template <typename Ret, typename F>
+Ret recovered(std::true_type /*is_void*/, F&& f, std::error_code error) {
+  rms::invoke(std::forward<F>(f), error);
+  return Ret(error);
+}
+
+template <typename Ret, typename F>
+Ret recovered(std::false_type /*is_void*/, F&& f, std::error_code error) {
+  static_assert(std::is_same<decay_t<decltype(rms::invoke(
+                                 std::forward<F>(f), error))>,
+                             Ret>::value,
+                "F must return the same ValueOrError or void");
+  return rms::invoke(std::forward<F>(f), error);
+}
+
+template <typename Ret, typename F>
+VOE_COLD Ret recovered(F&& f, std::error_code error) {
+  using Result = decltype(rms::invoke(std::forward<F>(f), error));
+  return recovered<Ret>(std::is_void<Result>(), std::forward<F>(f), error);
+}
+
+// Fallback of value_or_else(). F takes the error or nothing.
+template <typename F>
+auto invoke_fallback(F&& f, std::error_code error, int /*preferred*/)
+    -> decltype(rms::invoke(std::forward<F>(f), error)) {
+  return rms::invoke(std::forward<F>(f), error);
+}
+
+template <typename F>
+auto invoke_fallback(F&& f, std::error_code /*unused*/,
+                     long /*fallback*/)  // NOLINT
+    -> decltype(rms::invoke(std::forward<F>(f))) {
+  return rms::invoke(std::forward<F>(f));
+}
+
+template <typename T, typename F>
+VOE_COLD T fallback_value(F&& f, std::error_code error) {
+  return static_cast<T>(invoke_fallback(std::forward<F>(f), error, 0));
+}
+
+// Storage of ValueOrError for arbitrary T. Owns the alive member of the union
+// and aborts on destruction of an error which was never checked.
+// E is a trivially copyable error representation.
+template <typename T, typename E>
+class Storage {
+ public:
+  using value_type = T;
+  using error_type = E;
+
+  Storage() noexcept : m_state(StateEmpty) {}
+
+  explicit Storage(error_type error) noexcept
+      : m_error(error), m_state(StateError) {}
+
+  template <typename... ArgTypes>
+  explicit Storage(in_place_t, ArgTypes&&... args)
+      : m_value(std::forward<ArgTypes>(args)...), m_state(StateValue) {}
+
+  // Copy gets only an alive value or error. It must be handled on its own.
+  Storage(Storage const& other) : m_state(StateEmpty) {
+    if (other.kind() == StateError) {
+      construct_error(other.m_error);
+    } else if (other.has_value()) {
+      construct_value(other.m_value);
+    }
+  }
+
+  Storage(Storage&& other) noexcept(
+      std::is_nothrow_move_constructible<value_type>::value)
+      : m_state(StateEmpty) {
+    move_from(std::move(other));
+  }
+
+  Storage& operator=(Storage const& other) {
+    if (this != &other) {
+      Storage copy(other);
+      // Empty while the value is moved in, a throwing move leaves it so
+      reset();
+      move_from(std::move(copy));
+    }
+    return *this;
+  }
+
+  Storage& operator=(Storage&& other) noexcept(
+      std::is_nothrow_move_constructible<value_type>::value) {
+    if (this != &other) {
+      reset();
+      move_from(std::move(other));
+    }
+    return *this;
+  }
+
+  ~Storage() {
+#if VOE_RUNTIME_CHECKS
+    if (kind() == StateError) {
+      // The error should be handled or explicitly ignored
+      if (VOE_UNLIKELY((m_state & StateHandled) == 0)) {
+        abort_unhandled_error();
+      }
+    }
+#endif
+    destroy();
+  }
+
+  std::uint8_t state() const noexcept { return m_state; }
+
+  std::uint8_t kind() const noexcept { return m_state & StateKindMask; }
+
+  bool has_value() const noexcept {
+    return (m_state & (StateKindMask | StateExtracted)) == StateValue;
+  }
+
+  void set_flags(std::uint8_t flags) noexcept { m_state |= flags; }
+
+#if VOE_RUNTIME_CHECKS
+  void mark_handled() const noexcept { m_state |= StateHandled; }
+
+  void unmark_handled() const noexcept { m_state &= ~StateHandled; }
+#else
+  void mark_handled() const noexcept {}
+
+  void unmark_handled() const noexcept {}
+#endif
+
+  // Precondition: kind() == StateError
+  error_type error() const noexcept { return m_error; }
+
+  // Precondition: kind() == StateValue
+  value_type& value() noexcept { return m_value; }
+
+  value_type const& value() const noexcept { return m_value; }
+
+  // Precondition: nothing is stored (freshly constructed or reset)
+  template <typename... ArgTypes>
+  void construct_value(ArgTypes&&... args) {
+    ::new (static_cast<void*>(&m_value))
+        value_type(std::forward<ArgTypes>(args)...);
+    m_state = StateValue;
+  }
+
+  // Precondition: nothing is stored (freshly constructed or reset)
+  void construct_error(error_type error) noexcept {
+    ::new (static_cast<void*>(&m_error)) error_type(error);
+    m_state = StateError;
+  }
+
+  void reset() noexcept {
+    destroy();
+    m_state = StateEmpty;
+  }
+
+  // Content travels together with its flags.
+  void swap(Storage& other) noexcept(
+      std::is_nothrow_move_constructible<value_type>::value &&
+      is_nothrow_swappable<value_type>::value) {
+    if (kind() == StateValue && other.kind() == StateValue) {
+      using std::swap;
+      swap(m_value, other.m_value);
+      swap(m_state, other.m_state);
+      return;
+    }
+    Storage tmp(std::move(other));
+    other = std::move(*this);
+    *this = std::move(tmp);
+  }
+
+ private:
+  void destroy() noexcept {
+    if (kind() == StateValue) {
+      m_value.~value_type();
+    }
+  }
+
+  // Precondition: nothing alive in this storage
+  void move_from(Storage&& other) {
+    if (other.kind() == StateError) {
+      ::new (static_cast<void*>(&m_error)) error_type(other.m_error);
+    } else if (other.kind() == StateValue) {
+      ::new (static_cast<void*>(&m_value))
+          value_type(std::move(other.m_value));
+    }
+    m_state = other.m_state;
+    // mark rhs as handled and without value to satisfy abort condition in the
+    // dtor and disallow further usage.
+    other.m_state |= StateHandled | StateExtracted;
+  }
+
+  // Discriminated by the kind bits of m_state. Nothing is alive when empty.
+  union {
+    error_type m_error;
+    value_type m_value;
+  };
+  // Mutable since checking the error marks it as handled
+  mutable std::uint8_t m_state;
+};
+
+// Storage for trivially copyable T. Copy, move and destruction are trivial,
+// so small results are returned in registers. Unhandled errors are detected
+// only with CheckedStorage on top of it.
+template <typename T, typename E>
+class TrivialStorage {
  public:
   using value_type = T;
-  using storage_type =
-      boost::variant<boost::blank, std::error_code, value_type>;
+  using error_type = E;
+
+  TrivialStorage() noexcept : m_error(), m_state(StateEmpty) {}
+
+  explicit TrivialStorage(error_type error) noexcept
+      : m_error(error), m_state(StateError) {}
+
+  template <typename... ArgTypes>
+  explicit TrivialStorage(in_place_t, ArgTypes&&... args)
+      : m_value(std::forward<ArgTypes>(args)...), m_state(StateValue) {}
 
-  template <typename E,
+  std::uint8_t state() const noexcept { return m_state; }
+
+  std::uint8_t kind() const noexcept { return m_state & StateKindMask; }
+
+  bool has_value() const noexcept {
+    return (m_state & (StateKindMask | StateExtracted)) == StateValue;
+  }
+
+  void set_flags(std::uint8_t flags) noexcept { m_state |= flags; }
+
+  // Nothing to track since the dtor is trivial
+  void mark_handled() const noexcept {}
+
+  void unmark_handled() const noexcept {}
+
+  // Precondition: kind() == StateError
+  error_type error() const noexcept { return m_error; }
+
+  // Precondition: kind() == StateValue
+  value_type& value() noexcept { return m_value; }
+
+  value_type const& value() const noexcept { return m_value; }
+
+  // Precondition: nothing is stored (freshly constructed or reset)
+  template <typename... ArgTypes>
+  void construct_value(ArgTypes&&... args) {
+    ::new (static_cast<void*>(&m_value))
+        value_type(std::forward<ArgTypes>(args)...);
+    m_state = StateValue;
+  }
+
+  // Precondition: nothing is stored (freshly constructed or reset)
+  void construct_error(error_type error) noexcept {
+    m_error = error;
+    m_state = StateError;
+  }
+
+  void reset() noexcept { m_state = StateEmpty; }
+
+  void swap(TrivialStorage& other) noexcept { std::swap(*this, other); }
+
+ protected:
+  union {
+    value_type m_value;
+    error_type m_error;
+  };
+  // Mutable for CheckedStorage
+  mutable std::uint8_t m_state;
+};
+
+// Trivial storage with std::error_code. The error is kept as a category
+// pointer and a value, where category shares space with the value. So results
+// of small T (up to 8 bytes) fit into 16 bytes.
+template <typename T>
+class TrivialStorage<T, std::error_code> {
+ public:
+  using value_type = T;
+  using error_type = std::error_code;
+
+  TrivialStorage() noexcept
+      : m_category(nullptr), m_code(0), m_state(StateEmpty) {}
+
+  explicit TrivialStorage(std::error_code error) noexcept
+      : m_category(&error.category()),
+        m_code(error.value()),
+        m_state(StateError) {}
+
+  template <typename... ArgTypes>
+  explicit TrivialStorage(in_place_t, ArgTypes&&... args)
+      : m_value(std::forward<ArgTypes>(args)...),
+        m_code(0),
+        m_state(StateValue) {}
+
+  std::uint8_t state() const noexcept { return m_state; }
+
+  std::uint8_t kind() const noexcept { return m_state & StateKindMask; }
+
+  bool has_value() const noexcept {
+    return (m_state & (StateKindMask | StateExtracted)) == StateValue;
+  }
+
+  void set_flags(std::uint8_t flags) noexcept { m_state |= flags; }
+
+  // Nothing to track since the dtor is trivial
+  void mark_handled() const noexcept {}
+
+  void unmark_handled() const noexcept {}
+
+  // Precondition: kind() == StateError
+  std::error_code error() const noexcept { return {m_code, *m_category}; }
+
+  // Precondition: kind() == StateValue
+  value_type& value() noexcept { return m_value; }
+
+  value_type const& value() const noexcept { return m_value; }
+
+  // Precondition: nothing is stored (freshly constructed or reset)
+  template <typename... ArgTypes>
+  void construct_value(ArgTypes&&... args) {
+    ::new (static_cast<void*>(&m_value))
+        value_type(std::forward<ArgTypes>(args)...);
+    m_state = StateValue;
+  }
+
+  // Precondition: nothing is stored (freshly constructed or reset)
+  void construct_error(std::error_code error) noexcept {
+    m_category = &error.category();
+    m_code = error.value();
+    m_state = StateError;
+  }
+
+  void reset() noexcept { m_state = StateEmpty; }
+
+  void swap(TrivialStorage& other) noexcept { std::swap(*this, other); }
+
+ protected:
+  union {
+    value_type m_value;
+    std::error_category const* m_category;
+  };
+  int m_code;
+  // Mutable for CheckedStorage
+  mutable std::uint8_t m_state;
+};
+
+// Runtime checks of Storage on top of a trivial storage. The layout is kept,
+// so results stay as small, but copy, move and destruction are not trivial.
+template <typename Base>
+class CheckedStorage : public Base {
+ public:
+  using Base::Base;
+
+  CheckedStorage() noexcept = default;
+
+  // Copy gets only an alive value or error. It must be handled on its own.
+  CheckedStorage(CheckedStorage const& other) noexcept : Base(other) {
+    this->m_state = other.alive_kind();
+  }
+
+  CheckedStorage(CheckedStorage&& other) noexcept : Base(other) {
+    other.m_state |= StateHandled | StateExtracted;
+  }
+
+  CheckedStorage& operator=(CheckedStorage const& other) noexcept {
+    Base::operator=(other);
+    this->m_state = other.alive_kind();
+    return *this;
+  }
+
+  CheckedStorage& operator=(CheckedStorage&& other) noexcept {
+    if (this != &other) {
+      Base::operator=(other);
+      other.m_state |= StateHandled | StateExtracted;
+    }
+    return *this;
+  }
+
+  ~CheckedStorage() {
+    // The error should be handled or explicitly ignored
+    if (VOE_UNLIKELY(this->kind() == StateError &&
+                     (this->m_state & StateHandled) == 0)) {
+      abort_unhandled_error();
+    }
+  }
+
+  void mark_handled() const noexcept { this->m_state |= StateHandled; }
+
+  void unmark_handled() const noexcept { this->m_state &= ~StateHandled; }
+
+ private:
+  std::uint8_t alive_kind() const noexcept {
+    if (this->kind() == StateError) {
+      return StateError;
+    }
+    return this->has_value() ? StateValue : StateEmpty;
+  }
+};
+
+// Trivial layout for trivially copyable T, checked unless VOE_CHECKING is off
+template <typename T, typename E>
+using storage_t = typename std::conditional<
+    std::is_trivially_copyable<T>::value,
+#if VOE_RUNTIME_CHECKS
+    CheckedStorage<TrivialStorage<T, E>>,
+#else
+    TrivialStorage<T, E>,
+#endif
+    Storage<T, E>>::type;
+
+}  // namespace detail
+
+// Unhandled error is detected at runtime (see VOE_CHECKING) and at compile
+// time when result of a function is discarded.
+// E is the representation of the stored error (see compact_error.h). It must
+// be trivially copyable and convertible to and from std::error_code.
+template <typename T, typename E = std::error_code>
+class VOE_NODISCARD ValueOrError {
+ public:
+  using value_type = T;
+  using error_type = E;
+  using storage_type = detail::storage_t<value_type, error_type>;
+
+  template <typename ErrorEnum,
             typename std::enable_if<
-                std::is_error_code_enum<E>::value ||
-                std::is_error_condition_enum<E>::value>::type* = nullptr>
+                std::is_error_code_enum<ErrorEnum>::value ||
+                std::is_error_condition_enum<ErrorEnum>::value>::type* =
+                nullptr>
   // cppcheck-suppress noExplicitConstructor
-  ValueOrError(E error_code)  // NOLINT
-      : m_has_error(true), m_storage(make_error_code(error_code)) {}
+  ValueOrError(ErrorEnum error_code)  // NOLINT
+      : m_storage(detail::error_from_enum<error_type>(error_code)) {}
 
   // cppcheck-suppress noExplicitConstructor
   ValueOrError(std::error_code error_code)  // NOLINT
-      : m_has_error(true), m_storage(error_code) {}
-
-  ValueOrError()
-      : m_has_error(false), m_storage(boost::blank()), m_empty_value(true) {}
+      : m_storage(detail::error_from_code<error_type>(error_code)) {}
 
-  template <typename U,
+  template <typename OtherE,
             typename std::enable_if<
-                !std::is_error_code_enum<typename std::decay<U>::type>::value &&
-                !std::is_error_condition_enum<
-                    typename std::decay<U>::type>::value>::type* = nullptr>
+                std::is_same<OtherE, E>::value &&
+                !std::is_same<OtherE, std::error_code>::value>::type* = nullptr>
+  // cppcheck-suppress noExplicitConstructor
+  ValueOrError(OtherE error)  // NOLINT
+      : m_storage(error) {}
+
+  ValueOrError() = default;
+
+#if VOE_COROUTINES
+  // Result of a coroutine, which is set by its promise later
+  template <typename Promise>
+  ValueOrError(detail::coroutine_result_t, Promise& promise)
+      : ValueOrError() {
+    promise.set_result_object(*this);
+  }
+#endif
+
+  template <typename U, typename std::enable_if<detail::is_value_argument<
+                            U, E>::value>::type* = nullptr>
   // cppcheck-suppress noExplicitConstructor
   ValueOrError(U&& value)  // NOLINT
-      : m_has_error(false),
-        m_storage(std::forward<U>(value)),
-        m_empty_value(false) {}
+      : m_storage(in_place, std::forward<U>(value)) {}
+
+  // Constructs the value in place from args
+  template <typename... ArgTypes>
+  explicit ValueOrError(in_place_t, ArgTypes&&... args)
+      : m_storage(in_place, std::forward<ArgTypes>(args)...) {}
 
-  ValueOrError(ValueOrError const& other) { copy_construct(other); }
+  template <typename U, typename... ArgTypes>
+  explicit ValueOrError(in_place_t, std::initializer_list<U> list,
+                        ArgTypes&&... args)
+      : m_storage(in_place, list, std::forward<ArgTypes>(args)...) {}
+
+  // Copy, move and destruction are delegated to the storage, so they are
+  // trivial for trivially copyable T without runtime checks.
+  ValueOrError(ValueOrError const& other) = default;
 
   template <typename OtherT, typename std::enable_if<std::is_convertible<
                                  OtherT, T>::value>::type* = nullptr>
   // cppcheck-suppress noExplicitConstructor
-  ValueOrError(ValueOrError<OtherT> const& other) {
+  ValueOrError(ValueOrError<OtherT, E> const& other) {
     copy_construct(other);
   }
 
   template <typename OtherT, typename std::enable_if<!std::is_convertible<
                                  OtherT, T const&>::value>::type* = nullptr>
-  explicit ValueOrError(ValueOrError<OtherT> const& other) {
+  explicit ValueOrError(ValueOrError<OtherT, E> const& other) {
     copy_construct(other);
   }
 
-  ValueOrError(ValueOrError&& other) { move_construct(std::move(other)); }
+  ValueOrError(ValueOrError&& other) = default;
 
   template <typename OtherT, typename std::enable_if<std::is_convertible<
                                  OtherT, T>::value>::type* = nullptr>
   // cppcheck-suppress noExplicitConstructor
-  ValueOrError(ValueOrError<OtherT>&& other) {
+  ValueOrError(ValueOrError<OtherT, E>&& other) noexcept(
+      std::is_nothrow_constructible<T, OtherT&&>::value) {
     move_construct(std::move(other));
   }
 
   template <typename OtherT, typename std::enable_if<!std::is_convertible<
                                  OtherT, T>::value>::type* = nullptr>
-  explicit ValueOrError(ValueOrError<OtherT>&& other) {
+  explicit ValueOrError(ValueOrError<OtherT, E>&& other) noexcept(
+      std::is_nothrow_constructible<T, OtherT&&>::value) {
     move_construct(std::move(other));
   }
 
-  ValueOrError& operator=(ValueOrError const& other) {
-    copy_assign(other);
-    return *this;
-  }
+  ValueOrError& operator=(ValueOrError const& other) = default;
 
   ValueOrError& operator=(ValueOrError&& other) = default;
 
-  ~ValueOrError() {
-    if (m_has_error) {
-      // The error should be handled or explicitly ignored
-      if (!m_handled) {
-        std::abort();
-      }
+  // Assigns to the stored value or constructs it in place, so no temporary
+  // ValueOrError is created.
+  template <typename U,
+            typename std::enable_if<
+                detail::is_value_argument<U, E>::value &&
+                std::is_constructible<T, U&&>::value &&
+                std::is_assignable<T&, U&&>::value>::type* = nullptr>
+  ValueOrError& operator=(U&& value) {
+    if (m_storage.has_value()) {
+      m_storage.value() = std::forward<U>(value);
+    } else {
+      m_storage.reset();
+      m_storage.construct_value(std::forward<U>(value));
     }
+    return *this;
   }
 
+  ~ValueOrError() = default;
+
+  void swap(ValueOrError& other) noexcept(
+      noexcept(std::declval<storage_type&>().swap(
+          std::declval<storage_type&>()))) {
+    m_storage.swap(other.m_storage);
+  }
+
+  // Replaces content with the value constructed in place from args.
+  // Result is empty if constructor of the value throws.
   template <typename... ArgTypes>
-  void emplace(ArgTypes&&... args) {
-    m_storage = value_type{std::forward<ArgTypes>(args)...};
-    m_empty_value = false;
+  value_type& emplace(ArgTypes&&... args) {
+    m_storage.reset();
+    m_storage.construct_value(std::forward<ArgTypes>(args)...);
+    return m_storage.value();
+  }
+
+  template <typename U, typename... ArgTypes>
+  value_type& emplace(std::initializer_list<U> list, ArgTypes&&... args) {
+    m_storage.reset();
+    m_storage.construct_value(list, std::forward<ArgTypes>(args)...);
+    return m_storage.value();
   }
 
   constexpr explicit operator bool() const noexcept {
-    return m_handled = true, !m_has_error;
+    return m_storage.mark_handled(), m_storage.kind() != detail::StateError;
   }
 
   std::error_code error() const {
-    m_handled = true;
-    return m_has_error ? boost::get<std::error_code>(m_storage)
-                       : std::error_code();
+    m_storage.mark_handled();
+    return m_storage.kind() == detail::StateError
+               ? static_cast<std::error_code>(m_storage.error())
+               : std::error_code();
   }
 
-  bool has_value() const noexcept { return !m_has_error && !m_empty_value; }
+  bool has_value() const noexcept { return m_storage.has_value(); }
 
   ValueOrError& ignore() noexcept {
-    m_handled = true;
+    m_storage.mark_handled();
     return *this;
   }
 
   ValueOrError& unignore() noexcept {
-    m_handled = false;
+    m_storage.unmark_handled();
     return *this;
   }
 
   value_type& value() {
     validate_value();
-    return boost::get<value_type>(m_storage);
+    return m_storage.value();
   }
 
   const value_type& value() const {
     validate_value();
-    return boost::get<value_type>(m_storage);
+    return m_storage.value();
   }
 
   T&& extract() {
     T&& result = std::move(value());
-    m_empty_value = true;
+    m_storage.set_flags(detail::StateExtracted);
     return std::move(result);
   }
 
@@ -161,9 +748,9 @@ class ValueOrError {
 
   T const& operator*() const { return value(); }
 
-  template <typename U>
+  template <typename U, typename OtherE>
   friend std::ostream& operator<<(std::ostream& output,
-                                  ValueOrError<U> const& obj);
+                                  ValueOrError<U, OtherE> const& obj);
 
   template <typename F>
   constexpr auto then(F&& f) & {
@@ -185,56 +772,181 @@ class ValueOrError {
     return then_impl(std::move(*this), std::forward<F>(f));
   }
 
- private:
-  template <typename OtherT>
-  friend class ValueOrError;
+  // f: T -> U. Result is ValueOrError<U, E> (ValueOrError<void, E> for void
+  // f). The value of rvalue result is moved to f.
+  template <typename F>
+  auto map(F&& f) & {
+    return map_impl(*this, std::forward<F>(f));
+  }
 
-  template <typename OtherT>
-  void copy_construct(ValueOrError<OtherT> const& other) {
-    m_has_error = other.m_has_error;
-    m_storage = other.m_storage;
+  template <typename F>
+  auto map(F&& f) && {
+    return map_impl(std::move(*this), std::forward<F>(f));
   }
 
-  template <typename T1>
-  static bool compare_this_if_same_type(T1 const& a, T1 const& b) noexcept {
-    return &a == &b;
+  template <typename F>
+  auto map(F&& f) const& {
+    return map_impl(*this, std::forward<F>(f));
+  }
+
+  template <typename F>
+  auto map(F&& f) const&& {
+    return map_impl(std::move(*this), std::forward<F>(f));
+  }
+
+  // f: std::error_code -> std::error_code, error enum or E. Value is passed
+  // through untouched.
+  template <typename F>
+  ValueOrError map_error(F&& f) const& {
+    return map_error_impl(*this, std::forward<F>(f));
+  }
+
+  template <typename F>
+  ValueOrError map_error(F&& f) && {
+    return map_error_impl(std::move(*this), std::forward<F>(f));
+  }
+
+  // f: std::error_code -> ValueOrError<T, E> to recover from the error, or
+  // std::error_code -> void to observe it (the error is kept).
+  template <typename F>
+  ValueOrError or_else(F&& f) const& {
+    return or_else_impl(*this, std::forward<F>(f));
+  }
+
+  template <typename F>
+  ValueOrError or_else(F&& f) && {
+    return or_else_impl(std::move(*this), std::forward<F>(f));
+  }
+
+  // Value or default_value if error is stored. The error counts as handled.
+  template <typename U>
+  value_type value_or(U&& default_value) const& {
+    m_storage.mark_handled();
+    if (VOE_LIKELY(has_value())) {
+      return m_storage.value();
+    }
+    return static_cast<value_type>(std::forward<U>(default_value));
+  }
+
+  template <typename U>
+  value_type value_or(U&& default_value) && {
+    m_storage.mark_handled();
+    if (VOE_LIKELY(has_value())) {
+      m_storage.set_flags(detail::StateExtracted);
+      return std::move(m_storage.value());
+    }
+    return static_cast<value_type>(std::forward<U>(default_value));
+  }
+
+  // Same as value_or(), but the default value is made by f() or
+  // f(std::error_code) only when it is needed.
+  template <typename F>
+  value_type value_or_else(F&& f) const& {
+    if (VOE_LIKELY(has_value())) {
+      return m_storage.value();
+    }
+    return detail::fallback_value<value_type>(std::forward<F>(f), error());
   }
 
-  template <typename T1, typename T2>
-  static bool compare_this_if_same_type(T1 const&, T2 const&) noexcept {
-    return false;
+  template <typename F>
+  value_type value_or_else(F&& f) && {
+    if (VOE_LIKELY(has_value())) {
+      m_storage.set_flags(detail::StateExtracted);
+      return std::move(m_storage.value());
+    }
+    return detail::fallback_value<value_type>(std::forward<F>(f), error());
+  }
+
+ private:
+  template <typename OtherT, typename OtherE>
+  friend class ValueOrError;
+
+  // Reference to the stored value with the value category and constness of
+  // ValueOrError of type Exp
+  template <typename Exp,
+            typename U = typename std::conditional<
+                std::is_const<typename std::remove_reference<Exp>::type>::value,
+                T const, T>::type>
+  using forward_value_t =
+      typename std::conditional<std::is_lvalue_reference<Exp>::value, U&,
+                                U&&>::type;
+
+  // Argument of F in then() and map(): the value of an rvalue result is
+  // moved, unless F takes only T&, then it is passed as an lvalue
+  template <typename Exp, typename F, typename Value = forward_value_t<Exp>>
+  using value_arg_t = typename std::conditional<
+      is_invocable<F, Value>::value, Value,
+      typename std::remove_reference<Value>::type&>::type;
+
+  // Precondition: exp.has_value()
+  template <typename Exp, typename F>
+  static value_arg_t<Exp, F> value_arg(Exp&& exp) noexcept {
+    return static_cast<value_arg_t<Exp, F>>(exp.m_storage.value());
   }
 
+  // Copy gets only an alive value or error. It must be handled on its own.
   template <typename OtherT>
-  void copy_assign(ValueOrError<OtherT> const& other) {
-    if (compare_this_if_same_type(*this, other)) {
-      return;
+  void copy_construct(ValueOrError<OtherT, E> const& other) {
+    if (other.m_storage.kind() == detail::StateError) {
+      m_storage.construct_error(other.m_storage.error());
+    } else if (other.has_value()) {
+      m_storage.construct_value(other.m_storage.value());
     }
-    ValueOrError copy(other);
-    std::swap(*this, copy);
   }
 
   template <typename OtherT>
-  void move_construct(ValueOrError<OtherT>&& other) {
-    m_storage = std::move(other.m_storage);
-    m_has_error = other.m_has_error;
-    m_handled = other.m_handled;
-    m_empty_value = other.m_empty_value;
+  void move_construct(ValueOrError<OtherT, E>&& other) {
+    if (other.m_storage.kind() == detail::StateError) {
+      m_storage.construct_error(other.m_storage.error());
+    } else if (other.m_storage.kind() == detail::StateValue) {
+      m_storage.construct_value(std::move(other.m_storage.value()));
+    }
+    m_storage.set_flags(other.m_storage.state() & ~detail::StateKindMask);
     // mark rhs as handled and without value to satisfy abort condition in the
     // dtor and disallow further usage.
-    other.m_handled = true;
-    other.m_empty_value = true;
+    other.m_storage.mark_handled();
+    other.m_storage.set_flags(detail::StateExtracted);
   }
 
   template <class Exp, class F,
-            class Ret = decltype(invoke(std::declval<F>(),
-                                        *std::declval<Exp>()))>
-  constexpr auto then_impl(Exp&& exp, F&& f) {
+            class Ret = decltype(rms::invoke(
+                std::declval<F>(), std::declval<value_arg_t<Exp, F>>()))>
+  static constexpr auto then_impl(Exp&& exp, F&& f) {
     static_assert(is_value_or_error<Ret>::value,
                   "F must return an ValueOrError");
 
-    return exp.has_value() ? invoke(std::forward<F>(f), *std::forward<Exp>(exp))
-                           : exp.error();
+    return VOE_LIKELY(exp.has_value())
+               ? rms::invoke(std::forward<F>(f),
+                             value_arg<Exp, F>(std::forward<Exp>(exp)))
+               : detail::propagate_error<Ret>(exp.error());
+  }
+
+  template <typename Exp, typename F,
+            typename U = invoke_result_t<F, value_arg_t<Exp, F>>,
+            typename Ret = ValueOrError<decay_t<U>, E>>
+  static Ret map_impl(Exp&& exp, F&& f) {
+    if (VOE_LIKELY(exp.has_value())) {
+      return detail::invoke_wrapped<Ret>(
+          std::is_void<U>(), std::forward<F>(f),
+          value_arg<Exp, F>(std::forward<Exp>(exp)));
+    }
+    return detail::propagate_error<Ret>(exp.error());
+  }
+
+  template <typename Exp, typename F>
+  static ValueOrError map_error_impl(Exp&& exp, F&& f) {
+    if (VOE_LIKELY(exp.m_storage.kind() != detail::StateError)) {
+      return ValueOrError(std::forward<Exp>(exp));
+    }
+    return detail::mapped_error<ValueOrError>(std::forward<F>(f), exp.error());
+  }
+
+  template <typename Exp, typename F>
+  static ValueOrError or_else_impl(Exp&& exp, F&& f) {
+    if (VOE_LIKELY(exp.m_storage.kind() != detail::StateError)) {
+      return ValueOrError(std::forward<Exp>(exp));
+    }
+    return detail::recovered<ValueOrError>(std::forward<F>(f), exp.error());
   }
 
   template <typename OtherT,
@@ -252,46 +964,379 @@ class ValueOrError {
   }
 
   void validate_value() const {
-    if (m_has_error) {
-      throw std::logic_error("Cannot get value. Error is already stored.");
+    if (VOE_UNLIKELY(!has_value())) {
+      detail::throw_bad_value_access(m_storage.kind());
+    }
+  }
+
+  storage_type m_storage;
+};
+
+// Success or error without payload. Default constructed result is success.
+// Same size as std::error_code, returned in registers without runtime checks.
+template <typename E>
+class VOE_NODISCARD ValueOrError<void, E> {
+ public:
+  using value_type = void;
+  using error_type = E;
+  using storage_type = detail::storage_t<detail::Unit, error_type>;
+
+  template <typename ErrorEnum,
+            typename std::enable_if<
+                std::is_error_code_enum<ErrorEnum>::value ||
+                std::is_error_condition_enum<ErrorEnum>::value>::type* =
+                nullptr>
+  // cppcheck-suppress noExplicitConstructor
+  ValueOrError(ErrorEnum error_code)  // NOLINT
+      : m_storage(detail::error_from_enum<error_type>(error_code)) {}
+
+  // cppcheck-suppress noExplicitConstructor
+  ValueOrError(std::error_code error_code)  // NOLINT
+      : m_storage(detail::error_from_code<error_type>(error_code)) {}
+
+  template <typename OtherE,
+            typename std::enable_if<
+                std::is_same<OtherE, E>::value &&
+                !std::is_same<OtherE, std::error_code>::value>::type* = nullptr>
+  // cppcheck-suppress noExplicitConstructor
+  ValueOrError(OtherE error)  // NOLINT
+      : m_storage(error) {}
+
+  ValueOrError() : m_storage(in_place) {}
+
+#if VOE_COROUTINES
+  // Result of a coroutine, which is set by its promise later
+  template <typename Promise>
+  ValueOrError(detail::coroutine_result_t, Promise& promise)
+      : ValueOrError() {
+    promise.set_result_object(*this);
+  }
+#endif
+
+  explicit ValueOrError(in_place_t) : m_storage(in_place) {}
+
+  explicit operator bool() const noexcept {
+    return m_storage.mark_handled(), m_storage.kind() != detail::StateError;
+  }
+
+  std::error_code error() const {
+    m_storage.mark_handled();
+    return m_storage.kind() == detail::StateError
+               ? static_cast<std::error_code>(m_storage.error())
+               : std::error_code();
+  }
+
+  bool has_value() const noexcept { return m_storage.has_value(); }
+
+  ValueOrError& ignore() noexcept {
+    m_storage.mark_handled();
+    return *this;
+  }
+
+  ValueOrError& unignore() noexcept {
+    m_storage.unmark_handled();
+    return *this;
+  }
+
+  // Throws if error is stored
+  void value() const { validate_value(); }
+
+  void extract() {
+    validate_value();
+    m_storage.set_flags(detail::StateExtracted);
+  }
+
+  void swap(ValueOrError& other) noexcept { m_storage.swap(other.m_storage); }
+
+  template <typename U, typename OtherE>
+  friend std::ostream& operator<<(std::ostream& output,
+                                  ValueOrError<U, OtherE> const& obj);
+
+  template <typename F>
+  auto then(F&& f) const {
+    using Ret = decltype(rms::invoke(std::declval<F>()));
+    static_assert(is_value_or_error<Ret>::value,
+                  "F must return an ValueOrError");
+
+    return VOE_LIKELY(has_value()) ? rms::invoke(std::forward<F>(f))
+                                   : detail::propagate_error<Ret>(error());
+  }
+
+  // f: void -> U. Result is ValueOrError<U, E>.
+  template <typename F, typename U = invoke_result_t<F>,
+            typename Ret = ValueOrError<decay_t<U>, E>>
+  Ret map(F&& f) const {
+    if (VOE_LIKELY(has_value())) {
+      return detail::invoke_wrapped<Ret>(std::is_void<U>(), std::forward<F>(f));
+    }
+    return detail::propagate_error<Ret>(error());
+  }
+
+  // See ValueOrError<T, E>::map_error()
+  template <typename F>
+  ValueOrError map_error(F&& f) const {
+    if (VOE_LIKELY(m_storage.kind() != detail::StateError)) {
+      return *this;
+    }
+    return detail::mapped_error<ValueOrError>(std::forward<F>(f), error());
+  }
+
+  // See ValueOrError<T, E>::or_else()
+  template <typename F>
+  ValueOrError or_else(F&& f) const {
+    if (VOE_LIKELY(m_storage.kind() != detail::StateError)) {
+      return *this;
+    }
+    return detail::recovered<ValueOrError>(std::forward<F>(f), error());
+  }
+
+ private:
+  template <typename OtherT>
+  static void value_to_stream(std::ostream& os) {
+    os << "<value>";
+  }
+
+  void validate_value() const {
+    if (VOE_UNLIKELY(!has_value())) {
+      detail::throw_bad_value_access(m_storage.kind());
     }
-    const auto is_has_value = has_value();
-    if (!is_has_value) {
-      throw std::logic_error("Value is not stored.");
+  }
+
+  storage_type m_storage;
+};
+
+// Borrowed value owned elsewhere or error. Keeps a pointer, so nothing is
+// copied (and without runtime checks the result is trivially copyable).
+// Binds to lvalues only.
+template <typename T, typename E>
+class VOE_NODISCARD ValueOrError<T&, E> {
+ public:
+  using value_type = T&;
+  using error_type = E;
+  using storage_type = detail::storage_t<T*, error_type>;
+
+  template <typename ErrorEnum,
+            typename std::enable_if<
+                std::is_error_code_enum<ErrorEnum>::value ||
+                std::is_error_condition_enum<ErrorEnum>::value>::type* =
+                nullptr>
+  // cppcheck-suppress noExplicitConstructor
+  ValueOrError(ErrorEnum error_code)  // NOLINT
+      : m_storage(detail::error_from_enum<error_type>(error_code)) {}
+
+  // cppcheck-suppress noExplicitConstructor
+  ValueOrError(std::error_code error_code)  // NOLINT
+      : m_storage(detail::error_from_code<error_type>(error_code)) {}
+
+  template <typename OtherE,
+            typename std::enable_if<
+                std::is_same<OtherE, E>::value &&
+                !std::is_same<OtherE, std::error_code>::value>::type* = nullptr>
+  // cppcheck-suppress noExplicitConstructor
+  ValueOrError(OtherE error)  // NOLINT
+      : m_storage(error) {}
+
+  ValueOrError() = default;
+
+#if VOE_COROUTINES
+  // Result of a coroutine, which is set by its promise later
+  template <typename Promise>
+  ValueOrError(detail::coroutine_result_t, Promise& promise)
+      : ValueOrError() {
+    promise.set_result_object(*this);
+  }
+#endif
+
+  template <typename U, typename std::enable_if<std::is_convertible<
+                            U*, T*>::value>::type* = nullptr>
+  // cppcheck-suppress noExplicitConstructor
+  ValueOrError(U& value)  // NOLINT
+      : m_storage(in_place, std::addressof(value)) {}
+
+  template <typename U, typename std::enable_if<std::is_convertible<
+                            U*, T*>::value>::type* = nullptr>
+  // cppcheck-suppress noExplicitConstructor
+  ValueOrError(ValueOrError<U&, E> const& other) {  // NOLINT
+    if (other.m_storage.kind() == detail::StateError) {
+      m_storage.construct_error(other.m_storage.error());
+    } else if (other.has_value()) {
+      m_storage.construct_value(other.m_storage.value());
+    }
+  }
+
+  constexpr explicit operator bool() const noexcept {
+    return m_storage.mark_handled(), m_storage.kind() != detail::StateError;
+  }
+
+  std::error_code error() const {
+    m_storage.mark_handled();
+    return m_storage.kind() == detail::StateError
+               ? static_cast<std::error_code>(m_storage.error())
+               : std::error_code();
+  }
+
+  bool has_value() const noexcept { return m_storage.has_value(); }
+
+  ValueOrError& ignore() noexcept {
+    m_storage.mark_handled();
+    return *this;
+  }
+
+  ValueOrError& unignore() noexcept {
+    m_storage.unmark_handled();
+    return *this;
+  }
+
+  T& value() const {
+    validate_value();
+    return *m_storage.value();
+  }
+
+  T& extract() {
+    T& result = value();
+    m_storage.set_flags(detail::StateExtracted);
+    return result;
+  }
+
+  T* operator->() const { return &value(); }
+
+  T& operator*() const { return value(); }
+
+  void swap(ValueOrError& other) noexcept { m_storage.swap(other.m_storage); }
+
+  template <typename U, typename OtherE>
+  friend std::ostream& operator<<(std::ostream& output,
+                                  ValueOrError<U, OtherE> const& obj);
+
+  template <typename F>
+  constexpr auto then(F&& f) const {
+    using Ret = decltype(rms::invoke(std::declval<F>(), std::declval<T&>()));
+    static_assert(is_value_or_error<Ret>::value,
+                  "F must return an ValueOrError");
+
+    return VOE_LIKELY(has_value())
+               ? rms::invoke(std::forward<F>(f), *m_storage.value())
+               : detail::propagate_error<Ret>(error());
+  }
+
+  // f: T& -> U. Result is ValueOrError<U, E>.
+  template <typename F, typename U = invoke_result_t<F, T&>,
+            typename Ret = ValueOrError<decay_t<U>, E>>
+  Ret map(F&& f) const {
+    if (VOE_LIKELY(has_value())) {
+      return detail::invoke_wrapped<Ret>(std::is_void<U>(), std::forward<F>(f),
+                                         *m_storage.value());
+    }
+    return detail::propagate_error<Ret>(error());
+  }
+
+  // See ValueOrError<T, E>::map_error()
+  template <typename F>
+  ValueOrError map_error(F&& f) const {
+    if (VOE_LIKELY(m_storage.kind() != detail::StateError)) {
+      return *this;
+    }
+    return detail::mapped_error<ValueOrError>(std::forward<F>(f), error());
+  }
+
+  // See ValueOrError<T, E>::or_else()
+  template <typename F>
+  ValueOrError or_else(F&& f) const {
+    if (VOE_LIKELY(m_storage.kind() != detail::StateError)) {
+      return *this;
+    }
+    return detail::recovered<ValueOrError>(std::forward<F>(f), error());
+  }
+
+  // Borrowed value or default_value if error is stored
+  T& value_or(T& default_value) const noexcept {
+    m_storage.mark_handled();
+    return VOE_LIKELY(has_value()) ? *m_storage.value() : default_value;
+  }
+
+ private:
+  template <typename OtherT, typename OtherE>
+  friend class ValueOrError;
+
+  template <typename OtherT,
+            typename std::enable_if<is_streamable<
+                std::stringstream, OtherT>::value>::type* = nullptr>
+  void value_to_stream(std::ostream& os) const {
+    os << value();
+  }
+
+  template <typename OtherT,
+            typename std::enable_if<!is_streamable<
+                std::stringstream, OtherT>::value>::type* = nullptr>
+  static void value_to_stream(std::ostream& os) {
+    os << "<value>";
+  }
+
+  void validate_value() const {
+    if (VOE_UNLIKELY(!has_value())) {
+      detail::throw_bad_value_access(m_storage.kind());
     }
   }
 
-  mutable bool m_handled = false;
-  bool m_has_error;
   storage_type m_storage;
-  // TODO(malirod): query storage whether it's empty or not
-  bool m_empty_value = true;
 };
 
 // Trait for checking if a type is a ValueOrError
-template <typename T>
-struct is_value_or_error_impl<ValueOrError<T>> : std::true_type {};
+template <typename T, typename E>
+struct is_value_or_error_impl<ValueOrError<T, E>> : std::true_type {};
+
+// Result objects are returned from every call, so keep them compact: payload
+// and error share storage and all bookkeeping fits into a single byte.
+static_assert(sizeof(ValueOrError<int>) <= sizeof(std::error_code) + 8,
+              "ValueOrError<int> exceeds size budget");
+static_assert(sizeof(ValueOrError<void>) == sizeof(std::error_code),
+              "ValueOrError<void> should be as small as the error");
+
+template <typename T, typename E = std::error_code, typename... ArgTypes>
+ValueOrError<T, E> make_value_or_error(ArgTypes&&... args) {
+  return ValueOrError<T, E>(in_place, std::forward<ArgTypes>(args)...);
+}
+
+template <typename T, typename E = std::error_code, typename U,
+          typename... ArgTypes>
+ValueOrError<T, E> make_value_or_error(std::initializer_list<U> list,
+                                       ArgTypes&&... args) {
+  return ValueOrError<T, E>(in_place, list, std::forward<ArgTypes>(args)...);
+}
 
 template <typename T, typename E>
-typename std::enable_if<std::is_error_code_enum<E>::value ||
-                            std::is_error_condition_enum<E>::value,
+void swap(ValueOrError<T, E>& lhs,
+          ValueOrError<T, E>& rhs) noexcept(noexcept(lhs.swap(rhs))) {
+  lhs.swap(rhs);
+}
+
+template <typename T, typename E, typename ErrorEnum>
+typename std::enable_if<std::is_error_code_enum<ErrorEnum>::value ||
+                            std::is_error_condition_enum<ErrorEnum>::value,
                         bool>::type
-operator==(ValueOrError<T> const& error, E code) {
+operator==(ValueOrError<T, E> const& error, ErrorEnum code) {
   return error.error() == code;
 }
 
-template <typename T, typename E>
-typename std::enable_if<std::is_error_code_enum<E>::value ||
-                            std::is_error_condition_enum<E>::value,
+template <typename T, typename E, typename ErrorEnum>
+typename std::enable_if<std::is_error_code_enum<ErrorEnum>::value ||
+                            std::is_error_condition_enum<ErrorEnum>::value,
                         bool>::type
-operator!=(ValueOrError<T> const& error, E code) {
+operator!=(ValueOrError<T, E> const& error, ErrorEnum code) {
   return error.error() != code;
 }
 
-template <typename U>
-std::ostream& operator<<(std::ostream& output, ValueOrError<U> const& obj) {
-  if (obj.m_has_error) {
-    output << obj.error().message();
+template <typename U, typename E>
+std::ostream& operator<<(std::ostream& output,
+                         ValueOrError<U, E> const& obj) {
+  if (obj.m_storage.kind() == detail::StateError) {
+    auto const& error = obj.error();
+    // Messages of StaticMessageCategory are written without allocation
+    if (auto const* message = static_message(error)) {
+      output << message;
+    } else {
+      output << error.message();
+    }
   } else {
     if (!obj.has_value()) {
       output << "<empty>";
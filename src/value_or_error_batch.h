@@ -0,0 +1,259 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#pragma once
+
+/*
+ * Batch of results in structure of arrays layout:
+ *
+ * - values of all elements are stored contiguously, slots of failed
+ *   elements hold value-initialized T;
+ * - state is a bitmask with a set bit for each success, bits after size()
+ *   are always zero;
+ * - errors are kept in a side table of (index, error) sorted by index.
+ *
+ * So scanning for failures touches a bit per element (or nothing when the
+ * side table is empty) instead of the whole ValueOrError. Meant for large
+ * batches where almost all elements succeed.
+ *
+ * Errors stored in the batch are not tracked as unhandled. Results converted
+ * back to ValueOrError are tracked as usual.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "config.h"
+#include "value_or_error.h"
+
+namespace rms {
+namespace detail {
+
+using BatchWord = std::uint64_t;
+
+constexpr std::size_t BatchWordBits = 64U;
+
+// Precondition: word != 0
+inline std::size_t lowest_bit(BatchWord word) noexcept {
+  return static_cast<std::size_t>(__builtin_ctzll(word));
+}
+
+[[noreturn]] VOE_COLD inline void throw_empty_result() {
+  throw std::logic_error("Cannot store result. Neither value nor error.");
+}
+
+}  // namespace detail
+
+template <typename T, typename E = std::error_code>
+class ValueOrErrorBatch {
+ public:
+  using value_type = T;
+  using error_type = E;
+  using size_type = std::size_t;
+  using word_type = detail::BatchWord;
+  using result_type = ValueOrError<value_type, error_type>;
+
+  static_assert(std::is_default_constructible<value_type>::value,
+                "Slots of failed elements hold value-initialized T");
+
+  // Entry of the error side table
+  struct Error {
+    size_type index;
+    error_type error;
+  };
+
+  ValueOrErrorBatch() = default;
+
+  void reserve(size_type count) {
+    m_values.reserve(count);
+    m_mask.reserve(word_count(count));
+  }
+
+  void clear() noexcept {
+    m_values.clear();
+    m_mask.clear();
+    m_errors.clear();
+  }
+
+  size_type size() const noexcept { return m_values.size(); }
+
+  bool empty() const noexcept { return m_values.empty(); }
+
+  size_type error_count() const noexcept { return m_errors.size(); }
+
+  size_type value_count() const noexcept { return size() - error_count(); }
+
+  template <typename... ArgTypes>
+  value_type& emplace_value(ArgTypes&&... args) {
+    m_values.emplace_back(std::forward<ArgTypes>(args)...);
+    grow_mask();
+    m_mask.back() |= word_type(1U) << ((size() - 1U) % BitsPerWord);
+    return m_values.back();
+  }
+
+  void push_error(std::error_code error) {
+    m_values.emplace_back();
+    grow_mask();
+    try {
+      m_errors.push_back(
+          {size() - 1U, detail::error_from_code<error_type>(error)});
+    } catch (...) {
+      pop_slot();
+      throw;
+    }
+  }
+
+  // Moves the value or the error of result into the batch. The error counts
+  // as handled. Empty (or extracted) result throws std::logic_error.
+  void push_back(result_type&& result) {
+    if (VOE_LIKELY(result.has_value())) {
+      emplace_value(result.extract());
+    } else if (VOE_LIKELY(!result)) {
+      push_error(result.error());
+    } else {
+      detail::throw_empty_result();
+    }
+  }
+
+  void push_back(result_type const& result) {
+    if (VOE_LIKELY(result.has_value())) {
+      emplace_value(result.value());
+    } else if (VOE_LIKELY(!result)) {
+      push_error(result.error());
+    } else {
+      detail::throw_empty_result();
+    }
+  }
+
+  bool has_value(size_type index) const noexcept {
+    return (m_mask[index / BitsPerWord] >> (index % BitsPerWord)) & 1U;
+  }
+
+  // Precondition: has_value(index)
+  value_type& value(size_type index) noexcept { return m_values[index]; }
+
+  value_type const& value(size_type index) const noexcept {
+    return m_values[index];
+  }
+
+  // Success of the element is an empty error. O(log(error_count())).
+  std::error_code error(size_type index) const {
+    if (VOE_LIKELY(has_value(index))) {
+      return {};
+    }
+    auto const it = std::lower_bound(
+        m_errors.begin(), m_errors.end(), index,
+        [](Error const& error, size_type i) { return error.index < i; });
+    return static_cast<std::error_code>(it->error);
+  }
+
+  // Element as a borrowed result, nothing is copied
+  ValueOrError<value_type&, error_type> operator[](size_type index) {
+    if (VOE_LIKELY(has_value(index))) {
+      return m_values[index];
+    }
+    return error(index);
+  }
+
+  ValueOrError<value_type const&, error_type> operator[](
+      size_type index) const {
+    if (VOE_LIKELY(has_value(index))) {
+      return m_values[index];
+    }
+    return error(index);
+  }
+
+  // Element as an owning result. The value is moved out of the batch, the
+  // element stays a success which holds the moved-from value.
+  result_type extract(size_type index) {
+    if (VOE_LIKELY(has_value(index))) {
+      return result_type(in_place, std::move(m_values[index]));
+    }
+    return error(index);
+  }
+
+  // Calls f(index, value) for each success. O(size() / 64 + value_count()).
+  template <typename F>
+  void for_each_value(F&& f) {
+    for_each_bit(m_mask, [this, &f](size_type index) {
+      f(index, m_values[index]);
+    });
+  }
+
+  template <typename F>
+  void for_each_value(F&& f) const {
+    for_each_bit(m_mask, [this, &f](size_type index) {
+      f(index, m_values[index]);
+    });
+  }
+
+  // Calls f(index, error) for each failure. O(error_count()).
+  template <typename F>
+  void for_each_error(F&& f) const {
+    for (auto const& entry : m_errors) {
+      f(entry.index, static_cast<std::error_code>(entry.error));
+    }
+  }
+
+  // Raw layout for bulk algorithms
+  std::vector<value_type> const& values() const noexcept { return m_values; }
+
+  std::vector<word_type> const& value_mask() const noexcept { return m_mask; }
+
+  std::vector<Error> const& errors() const noexcept { return m_errors; }
+
+ private:
+  static constexpr size_type BitsPerWord = detail::BatchWordBits;
+
+  static constexpr size_type word_count(size_type count) noexcept {
+    return (count + BitsPerWord - 1U) / BitsPerWord;
+  }
+
+  // Called after the slot is appended. If the mask can't grow the slot is
+  // removed, so a throw leaves the batch as it was.
+  void grow_mask() {
+    if (m_mask.size() < word_count(size())) {
+      try {
+        m_mask.push_back(0U);
+      } catch (...) {
+        m_values.pop_back();
+        throw;
+      }
+    }
+  }
+
+  // Removes the last slot, which must be a failure
+  void pop_slot() noexcept {
+    m_values.pop_back();
+    if (m_mask.size() > word_count(size())) {
+      m_mask.pop_back();
+    }
+  }
+
+  template <typename F>
+  static void for_each_bit(std::vector<word_type> const& mask, F&& f) {
+    for (size_type i = 0U; i < mask.size(); ++i) {
+      auto word = mask[i];
+      if (VOE_LIKELY(word == ~word_type(0U))) {
+        // Dense run, a plain loop the compiler can vectorize
+        for (size_type bit = 0U; bit < BitsPerWord; ++bit) {
+          f(i * BitsPerWord + bit);
+        }
+        continue;
+      }
+      for (; word != 0U; word &= word - 1U) {
+        f(i * BitsPerWord + detail::lowest_bit(word));
+      }
+    }
+  }
+
+  std::vector<value_type> m_values;
+  std::vector<word_type> m_mask;
+  std::vector<Error> m_errors;
+};
+
+}  // namespace rms
@@ -0,0 +1,145 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#pragma once
+
+/*
+ * Chase-Lev work-stealing deque of pointers (Le, Pop, Cohen, Nardelli
+ * "Correct and Efficient Work-Stealing for Weak Memory Models", 2013).
+ *
+ * The owner thread pushes and pops at the bottom (LIFO), other threads steal
+ * from the top (FIFO). pop() and steal() return nullptr if the deque is empty
+ * or the last item was taken by someone else. The buffer grows when it is
+ * full. Old buffers may still be read by thieves, so they are kept until the
+ * deque is destroyed. Items left in the deque are not owned by it.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace rms {
+namespace detail {
+
+template <typename T>
+class WorkStealingDeque {
+ public:
+  explicit WorkStealingDeque(std::size_t capacity = 256U) {
+    grow(nullptr, 0, 0, round_up(capacity));
+  }
+
+  WorkStealingDeque(WorkStealingDeque const&) = delete;
+  WorkStealingDeque& operator=(WorkStealingDeque const&) = delete;
+
+  // Owner only
+  void push(T* item) {
+    auto const bottom = m_bottom.load(std::memory_order_relaxed);
+    auto const top = m_top.load(std::memory_order_acquire);
+    auto* array = m_array.load(std::memory_order_relaxed);
+    if (bottom - top >= array->capacity()) {
+      array = grow(array, top, bottom, array->capacity() * 2);
+    }
+    array->put(bottom, item);
+    // Release publishes the item (and what it points to) to thieves
+    m_bottom.store(bottom + 1, std::memory_order_release);
+  }
+
+  // Owner only
+  T* pop() {
+    auto const bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    auto* array = m_array.load(std::memory_order_relaxed);
+    m_bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto top = m_top.load(std::memory_order_relaxed);
+    if (top > bottom) {
+      m_bottom.store(bottom + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    auto* item = array->get(bottom);
+    if (top == bottom) {
+      // Last item, thieves compete for it
+      if (!m_top.compare_exchange_strong(top, top + 1,
+                                         std::memory_order_seq_cst,
+                                         std::memory_order_relaxed)) {
+        item = nullptr;
+      }
+      m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return item;
+  }
+
+  // Any thread
+  T* steal() {
+    auto top = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto const bottom = m_bottom.load(std::memory_order_acquire);
+    if (top >= bottom) {
+      return nullptr;
+    }
+    auto* item = m_array.load(std::memory_order_acquire)->get(top);
+    if (!m_top.compare_exchange_strong(top, top + 1,
+                                       std::memory_order_seq_cst,
+                                       std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return item;
+  }
+
+  // Approximation when called concurrently with the owner or thieves
+  bool empty() const noexcept {
+    return m_bottom.load(std::memory_order_acquire) <=
+           m_top.load(std::memory_order_acquire);
+  }
+
+ private:
+  class Array {
+   public:
+    explicit Array(std::int64_t capacity)
+        : m_mask(capacity - 1),
+          m_items(new std::atomic<T*>[static_cast<std::size_t>(capacity)]) {}
+
+    std::int64_t capacity() const noexcept { return m_mask + 1; }
+
+    T* get(std::int64_t index) const noexcept {
+      return m_items[static_cast<std::size_t>(index & m_mask)].load(
+          std::memory_order_relaxed);
+    }
+
+    void put(std::int64_t index, T* item) noexcept {
+      m_items[static_cast<std::size_t>(index & m_mask)].store(
+          item, std::memory_order_relaxed);
+    }
+
+   private:
+    std::int64_t const m_mask;
+    std::unique_ptr<std::atomic<T*>[]> m_items;
+  };
+
+  static std::int64_t round_up(std::size_t capacity) noexcept {
+    std::int64_t result = 1;
+    while (result < static_cast<std::int64_t>(capacity)) {
+      result *= 2;
+    }
+    return result;
+  }
+
+  Array* grow(Array* array, std::int64_t top, std::int64_t bottom,
+              std::int64_t capacity) {
+    m_arrays.emplace_back(new Array(capacity));
+    auto* grown = m_arrays.back().get();
+    for (auto i = top; i < bottom; ++i) {
+      grown->put(i, array->get(i));
+    }
+    m_array.store(grown, std::memory_order_release);
+    return grown;
+  }
+
+  std::atomic<std::int64_t> m_top{0};
+  std::atomic<std::int64_t> m_bottom{0};
+  // All buffers ever allocated, the last one is current
+  std::vector<std::unique_ptr<Array>> m_arrays;
+  std::atomic<Array*> m_array{nullptr};
+};
+
+}  // namespace detail
+}  // namespace rms
@@ -0,0 +1,143 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#include "batch_simd.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <random>
+#include <system_error>
+#include <vector>
+
+#include "value_or_error_batch.h"
+
+using rms::SimdLevel;
+using rms::ValueOrErrorBatch;
+
+namespace {
+
+// Size which has no vector kernel
+struct Triple {
+  std::uint8_t bytes[3];
+};
+
+template <typename T>
+T make_value(std::size_t i) {
+  return static_cast<T>(i * 3U + 1U);
+}
+
+template <>
+Triple make_value<Triple>(std::size_t i) {
+  return {{static_cast<std::uint8_t>(i), static_cast<std::uint8_t>(i >> 8U),
+           static_cast<std::uint8_t>(i >> 16U)}};
+}
+
+template <typename T>
+ValueOrErrorBatch<T> make_batch(std::size_t size, double error_rate) {
+  std::mt19937 generator(static_cast<std::uint32_t>(size));
+  std::bernoulli_distribution distribution(error_rate);
+  ValueOrErrorBatch<T> batch;
+  for (std::size_t i = 0U; i < size; ++i) {
+    if (distribution(generator)) {
+      batch.push_error(std::make_error_code(std::errc::invalid_argument));
+    } else {
+      batch.emplace_value(make_value<T>(i));
+    }
+  }
+  return batch;
+}
+
+std::vector<SimdLevel> supported_levels() {
+  std::vector<SimdLevel> levels;
+  for (auto const level :
+       {SimdLevel::Scalar, SimdLevel::Sse42, SimdLevel::Avx2}) {
+    if (rms::simd_supported(level)) {
+      levels.push_back(level);
+    }
+  }
+  return levels;
+}
+
+template <typename T>
+std::vector<std::size_t> value_indices(std::vector<T> const& values) {
+  std::vector<std::size_t> result;
+  for (auto const& value : values) {
+    result.push_back(static_cast<std::size_t>(value));
+  }
+  return result;
+}
+
+template <>
+std::vector<std::size_t> value_indices<Triple>(
+    std::vector<Triple> const& values) {
+  std::vector<std::size_t> result;
+  for (auto const& value : values) {
+    result.push_back(value.bytes[0] | (value.bytes[1] << 8U) |
+                     (value.bytes[2] << 16U));
+  }
+  return result;
+}
+
+template <typename T>
+void check_kernels() {
+  for (auto const size : {0U, 1U, 63U, 64U, 65U, 200U, 1000U, 4099U}) {
+    for (auto const error_rate : {0.0, 0.01, 0.5, 0.99, 1.0}) {
+      auto const batch = make_batch<T>(size, error_rate);
+      std::vector<T> expected_values;
+      batch.for_each_value([&expected_values](std::size_t, T const& value) {
+        expected_values.push_back(value);
+      });
+      std::vector<std::uint32_t> expected_errors;
+      batch.for_each_error([&expected_errors](std::size_t index,
+                                              std::error_code) {
+        expected_errors.push_back(static_cast<std::uint32_t>(index));
+      });
+
+      for (auto const level : supported_levels()) {
+        CAPTURE(size, error_rate, static_cast<int>(level));
+        REQUIRE(batch.error_count() == rms::count_errors(batch, level));
+
+        std::vector<T> values;
+        rms::compact_values(batch, values, level);
+        REQUIRE(value_indices(expected_values) == value_indices(values));
+
+        std::vector<std::uint32_t> errors;
+        rms::error_indices(batch, errors, level);
+        REQUIRE(expected_errors == errors);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST_CASE("Batch SIMD kernels", "[BatchSimd]") {
+  SECTION("scalar is always supported") {
+    REQUIRE(rms::simd_supported(SimdLevel::Scalar));
+    REQUIRE(rms::simd_supported(rms::simd_level()));
+  }
+
+  SECTION("4 byte values") { check_kernels<std::uint32_t>(); }
+
+  SECTION("8 byte values") { check_kernels<std::uint64_t>(); }
+
+  SECTION("values without vector kernel") { check_kernels<Triple>(); }
+
+  SECTION("output is exactly sized") {
+    auto const batch = make_batch<std::uint32_t>(1000U, 0.1);
+    for (auto const level : supported_levels()) {
+      // Kernels must not write past value_count() elements
+      std::vector<std::uint32_t> values(batch.value_count() + 8U, 0xdeadU);
+      REQUIRE(batch.value_count() ==
+              rms::compact_values(batch, values.data(), level));
+      for (std::size_t i = batch.value_count(); i < values.size(); ++i) {
+        REQUIRE(0xdeadU == values[i]);
+      }
+      std::vector<std::uint32_t> errors(batch.error_count() + 8U, 0xdeadU);
+      REQUIRE(batch.error_count() ==
+              rms::error_indices(batch, errors.data(), level));
+      for (std::size_t i = batch.error_count(); i < errors.size(); ++i) {
+        REQUIRE(0xdeadU == errors[i]);
+      }
+    }
+  }
+}
@@ -1,10 +1,26 @@
 // Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
 #include "business_service.h"
 
+#include <utility>
+
 #include "business_service_error.h"
+#include "db_error.h"
 #include "db_manager.h"
 #include "try.h"
 
+namespace {
+
+// DB errors which have a meaning for the service are re-categorized, the rest
+// are passed as is
+std::error_code to_service_error(std::error_code error) {
+  if (error == rms::DBError::QueryInterrupted) {
+    return rms::make_error_code(rms::BusinessServiceError::OperationCanceled);
+  }
+  return error;
+}
+
+}  // namespace
+
 rms::BusinessService::BusinessService(DBManager& db_manager)
     : m_db_manager(db_manager) {}
 
@@ -18,18 +34,15 @@ rms::ValueOrError<std::string> rms::BusinessService::get_customer_by_id(
     return m_current_error;
   }
 
-  auto customers_or_error = m_db_manager.get_customers();
-  if (!customers_or_error) {
-    return customers_or_error.error();
-  }
-
-  auto customers = customers_or_error.extract();
-  // lets assume id == index
-  if (id >= customers.size()) {
-    return rms::BusinessServiceError::ItemNotFound;
-  }
-
-  return customers[id];
+  return m_db_manager.get_customers().map_error(to_service_error).then(
+      [id](std::vector<std::string>&& customers)
+          -> rms::ValueOrError<std::string> {
+        // lets assume id == index
+        if (id >= customers.size()) {
+          return rms::BusinessServiceError::ItemNotFound;
+        }
+        return std::move(customers[id]);
+      });
 }
 
 rms::ValueOrError<bool> rms::BusinessService::is_current_customer_auth() const {
@@ -37,10 +50,11 @@ rms::ValueOrError<bool> rms::BusinessService::is_current_customer_auth() const {
     return m_current_error;
   }
 
-  return m_db_manager.get_active_customer().then(
-      [this](std::string const& customer) {
+  return m_db_manager.get_active_customer()
+      .then([this](std::string const& customer) {
         return m_db_manager.is_auth(customer);
-      });
+      })
+      .map_error(to_service_error);
 }
 
 rms::ValueOrError<bool> rms::BusinessService::is_current_customer_admin()
@@ -5,11 +5,6 @@
 
 using rms::BusinessServiceError;
 
-template <>
-rms::util::enum_util::EnumStrings<BusinessServiceError>::DataType
-    rms::util::enum_util::EnumStrings<BusinessServiceError>::data = {
-        "Success", "Item not found", "Operation canceled"};
-
 const std::error_category& rms::BusinessServiceCategory::get() {
   static BusinessServiceCategory instance;
   return instance;
@@ -30,8 +25,9 @@ const char* rms::BusinessServiceCategory::name() const noexcept {
   return "BusinessServiceCategory";
 }
 
-std::string rms::BusinessServiceCategory::message(int error_value) const {
-  using rms::util::enum_util::EnumToString;
+const char* rms::BusinessServiceCategory::message_chars(
+    int error_value) const noexcept {
+  using rms::util::enum_util::EnumToChars;
   using rms::util::enum_util::FromIntegral;
-  return EnumToString(FromIntegral<rms::BusinessServiceError>(error_value));
+  return EnumToChars(FromIntegral<rms::BusinessServiceError>(error_value));
 }
@@ -1,18 +1,25 @@
 // Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
 #pragma once
 
-#include <string>
 #include <system_error>
 
+#include "enum_util.h"
+#include "error_category.h"
+
 namespace rms {
 
-enum class BusinessServiceError { Success, ItemNotFound, OperationCanceled };
+#define RMS_BUSINESS_SERVICE_ERROR_LIST(X) \
+  X(Success, "Success")                    \
+  X(ItemNotFound, "Item not found")        \
+  X(OperationCanceled, "Operation canceled")
+
+RMS_ENUM_WITH_STRINGS(BusinessServiceError, RMS_BUSINESS_SERVICE_ERROR_LIST)
 
-class BusinessServiceCategory : public std::error_category {
+class BusinessServiceCategory : public StaticMessageCategory {
  public:
   const char* name() const noexcept override;
 
-  std::string message(int error_value) const override;
+  const char* message_chars(int error_value) const noexcept override;
 
   static const std::error_category& get();
 
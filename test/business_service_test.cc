@@ -75,6 +75,18 @@ TEST_CASE("Test for BusinessService", "BusinessService") {
     REQUIRE(customer_or_error.error() == rms::DBError::NoOpenDB);
   }
 
+  SECTION("Get customer by id with DBManager error mapped to BusinessService") {
+    // Arrange
+    db_manager.set_current_error(
+        rms::make_error_code(rms::DBError::QueryInterrupted));
+    // Act
+    auto customer_or_error = business_service.get_customer_by_id(1U);
+    // Assert
+    REQUIRE(!customer_or_error.has_value());
+    REQUIRE(customer_or_error.error() ==
+            rms::BusinessServiceError::OperationCanceled);
+  }
+
   SECTION("Get customer by id with standard error from DBManager layer") {
     // Arrange
     db_manager.set_current_error(
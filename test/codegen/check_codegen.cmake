@@ -0,0 +1,62 @@
+# Checks shape of code generated for probe functions.
+# Usage: cmake -DOBJDUMP=<objdump> -DOBJECT=<probes object> -DSPEC=<spec>
+#              -P <this script>
+# The spec is a cmake script with expectations expressed by functions below.
+# Only the main body of a probe is checked. Parts which compiler moved to
+# .text.unlikely ("[clone .cold]") are the error path and are not checked.
+
+execute_process(COMMAND "${OBJDUMP}" -d -r --no-show-raw-insn -C "${OBJECT}"
+                OUTPUT_VARIABLE disassembly
+                RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "Failed to disassemble ${OBJECT}")
+endif()
+
+# codegen_expect(<probe> [IN_REGISTERS] [MAX_INSTRUCTIONS <count>]
+#                [FORBID <regex>...])
+# IN_REGISTERS: result is returned in rax:rdx, not via hidden pointer in rdi.
+# MAX_INSTRUCTIONS: upper bound of instructions in the body, padding excluded.
+# FORBID: patterns which must not occur in the body, e.g. calls of functions
+# (relocations are included, so callee names are visible).
+function(codegen_expect probe)
+    cmake_parse_arguments(ARG "IN_REGISTERS" "MAX_INSTRUCTIONS" "FORBID" ${ARGN})
+
+    string(REGEX MATCH "<${probe}\\([^>]*\\)>:\n([^\n]+\n)+" body "${disassembly}")
+    if (NOT body)
+        message(FATAL_ERROR "Probe ${probe} is not found in ${OBJECT}")
+    endif()
+
+    # Result returned via memory is written through rdi or its copy
+    if (ARG_IN_REGISTERS AND body MATCHES "\\(%rdi\\)|mov +%rdi,%r")
+        message(FATAL_ERROR "${probe} returns result through memory:\n${body}")
+    endif()
+
+    foreach(pattern IN LISTS ARG_FORBID)
+        if (body MATCHES "${pattern}")
+            message(FATAL_ERROR "${probe} matches forbidden '${pattern}':\n${body}")
+        endif()
+    endforeach()
+
+    # Instruction lines start with spaces, relocation lines with tabs
+    string(REGEX MATCHALL "\n +[0-9a-f]+:\t" instructions "${body}")
+    string(REGEX MATCHALL "\n +[0-9a-f]+:\t(nop|data16|xchg +%ax,%ax)" padding "${body}")
+    list(LENGTH instructions instructions_count)
+    list(LENGTH padding padding_count)
+    math(EXPR count "${instructions_count} - ${padding_count}")
+    if (ARG_MAX_INSTRUCTIONS AND count GREATER ARG_MAX_INSTRUCTIONS)
+        message(FATAL_ERROR "${probe} has ${count} instructions, "
+                            "expected at most ${ARG_MAX_INSTRUCTIONS}:\n${body}")
+    endif()
+
+    message(STATUS "${probe}: ${count} instructions")
+endfunction()
+
+# codegen_forbid(<regex> <reason>)
+# Pattern must not occur anywhere in the object, cold parts included.
+function(codegen_forbid pattern reason)
+    if (disassembly MATCHES "${pattern}")
+        message(FATAL_ERROR "${reason}: '${pattern}' found in ${OBJECT}")
+    endif()
+endfunction()
+
+include("${SPEC}")
@@ -0,0 +1,32 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+// Probes for happy_path.cmake. Compiled with VOE_CHECKING_OFF, where the hot
+// path of ValueOrError must be as lean as hand-written error code checks.
+// Sources are only declared, so the compiler can't fold them.
+#include <cstddef>
+#include <string>
+#include <system_error>
+
+#include "try.h"
+#include "value_or_error.h"
+
+rms::ValueOrError<int> voe_probe_int_source(int value);
+rms::ValueOrError<std::string> voe_probe_string_source(int value);
+
+rms::ValueOrError<int> voe_probe_make_int(int value) {
+  if (value < 0) {
+    return std::make_error_code(std::errc::invalid_argument);
+  }
+  return value * 2;
+}
+
+rms::ValueOrError<int> voe_probe_then_chain(int value) {
+  return voe_probe_int_source(value)
+      .then([](int x) { return rms::ValueOrError<int>(x + 1); })
+      .then([](int x) { return rms::ValueOrError<int>(x * 2); })
+      .then([](int x) { return rms::ValueOrError<int>(x - 3); });
+}
+
+rms::ValueOrError<std::size_t> voe_probe_try_extract_string(int value) {
+  VOE_TRY_EXTRACT(text, voe_probe_string_source(value));
+  return text.size();
+}
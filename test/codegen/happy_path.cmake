@@ -0,0 +1,15 @@
+# Expectations for happy_path.cc (see check_codegen.cmake).
+# Bounds have some headroom over GCC and Clang output at -O2. Raise them only
+# with a reason.
+
+codegen_forbid("boost::.*variant" "ValueOrError must not use boost::variant")
+
+# Nothing aborts without runtime checks
+set(forbidden "abort" "boost::")
+
+codegen_expect(voe_probe_make_int IN_REGISTERS MAX_INSTRUCTIONS 12
+               FORBID ${forbidden})
+codegen_expect(voe_probe_then_chain IN_REGISTERS MAX_INSTRUCTIONS 60
+               FORBID ${forbidden})
+codegen_expect(voe_probe_try_extract_string IN_REGISTERS MAX_INSTRUCTIONS 60
+               FORBID ${forbidden})
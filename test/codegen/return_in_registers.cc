@@ -0,0 +1,28 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+// Probes for return_in_registers.cmake. Without runtime checks results of
+// trivially copyable small T must be returned in rax:rdx, not via hidden
+// pointer in rdi.
+#include <system_error>
+
+#include "value_or_error.h"
+
+rms::ValueOrError<int> voe_probe_return_int(int value) {
+  if (value < 0) {
+    return std::make_error_code(std::errc::invalid_argument);
+  }
+  return value;
+}
+
+rms::ValueOrError<bool> voe_probe_return_bool(int value) {
+  if (value < 0) {
+    return std::make_error_code(std::errc::invalid_argument);
+  }
+  return value == 0;
+}
+
+rms::ValueOrError<void> voe_probe_return_void(int value) {
+  if (value < 0) {
+    return std::make_error_code(std::errc::invalid_argument);
+  }
+  return {};
+}
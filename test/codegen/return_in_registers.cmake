@@ -0,0 +1,7 @@
+# Expectations for return_in_registers.cc (see check_codegen.cmake).
+# Without runtime checks results of trivially copyable small T are returned
+# in rax:rdx.
+
+foreach(probe voe_probe_return_int voe_probe_return_bool voe_probe_return_void)
+    codegen_expect(${probe} IN_REGISTERS)
+endforeach()
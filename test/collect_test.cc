@@ -0,0 +1,121 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#include "collect.h"
+
+#include <catch2/catch.hpp>
+
+#include <list>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "value_or_error.h"
+
+using rms::ValueOrError;
+
+namespace {
+
+ValueOrError<std::string> find_name(int id) {
+  if (id < 0) {
+    return std::make_error_code(std::errc::invalid_argument);
+  }
+  if (id > 9) {
+    return std::make_error_code(std::errc::result_out_of_range);
+  }
+  return std::string(16U, static_cast<char>('0' + id));
+}
+
+}  // namespace
+
+TEST_CASE("Collect", "[Collect]") {
+  SECTION("all values") {
+    std::vector<ValueOrError<std::string>> results;
+    results.emplace_back(std::string("a"));
+    results.emplace_back(std::string("b"));
+    auto values = rms::collect(std::move(results));
+    static_assert(std::is_same<ValueOrError<std::vector<std::string>>,
+                               decltype(values)>::value,
+                  "Result must be ValueOrError of vector");
+    REQUIRE(values);
+    REQUIRE(std::vector<std::string>{"a", "b"} == values.value());
+    // Values were moved out
+    REQUIRE_FALSE(results[0].has_value());
+  }
+
+  SECTION("lvalue range is copied") {
+    std::vector<ValueOrError<std::string>> results;
+    results.emplace_back(std::string("a"));
+    auto values = rms::collect(results);
+    REQUIRE(std::vector<std::string>{"a"} == values.value());
+    REQUIRE("a" == results[0].value());
+  }
+
+  SECTION("first error") {
+    std::vector<ValueOrError<int>> results;
+    results.emplace_back(1);
+    results.emplace_back(std::make_error_code(std::errc::timed_out));
+    results.emplace_back(std::make_error_code(std::errc::invalid_argument));
+    auto values = rms::collect(std::move(results));
+    REQUIRE(values == std::errc::timed_out);
+  }
+
+  SECTION("empty range") {
+    std::vector<ValueOrError<int>> results;
+    auto values = rms::collect(results);
+    REQUIRE(values);
+    REQUIRE(values.value().empty());
+  }
+
+  SECTION("output buffer") {
+    std::list<ValueOrError<int>> results = {1, 2, 3};
+    std::vector<int> out = {7};
+    out.reserve(16U);
+    auto const* data = out.data();
+    REQUIRE(rms::collect(results, out));
+    REQUIRE(std::vector<int>{1, 2, 3} == out);
+    REQUIRE(data == out.data());
+  }
+}
+
+TEST_CASE("Transform collect", "[Collect]") {
+  SECTION("all values") {
+    std::vector<int> const ids = {1, 2, 3};
+    auto names = rms::transform_collect(ids, find_name);
+    REQUIRE(names);
+    REQUIRE(3U == names.value().size());
+    REQUIRE(std::string(16U, '3') == names.value()[2]);
+    REQUIRE(3U == names.value().capacity());
+  }
+
+  SECTION("stops at first error") {
+    std::vector<int> const ids = {1, -1, 2, 10};
+    std::vector<int> called;
+    auto names = rms::transform_collect(ids, [&called](int id) {
+      called.push_back(id);
+      return find_name(id);
+    });
+    REQUIRE(names == std::errc::invalid_argument);
+    REQUIRE(std::vector<int>{1, -1} == called);
+  }
+
+  SECTION("output buffer keeps values before error") {
+    std::vector<int> const ids = {4, 5, 11};
+    std::vector<std::string> out;
+    auto result = rms::transform_collect(ids, find_name, out);
+    REQUIRE(result == std::errc::result_out_of_range);
+    REQUIRE(2U == out.size());
+  }
+
+  SECTION("elements of rvalue range are moved") {
+    std::vector<std::unique_ptr<int>> pointers;
+    pointers.push_back(std::make_unique<int>(1));
+    pointers.push_back(std::make_unique<int>(2));
+    auto values = rms::transform_collect(
+        std::move(pointers), [](std::unique_ptr<int>&& pointer) {
+          return ValueOrError<std::unique_ptr<int>>(std::move(pointer));
+        });
+    REQUIRE(2 == *values.value()[1]);
+    REQUIRE(nullptr == pointers[0]);
+  }
+}
@@ -0,0 +1,170 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#include "compact_error.h"
+
+#include <catch2/catch.hpp>
+
+#include <cerrno>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include "business_service_error.h"
+#include "db_error.h"
+
+using rms::BusinessServiceError;
+using rms::CompactErrorCode;
+using rms::CompactValueOrError;
+using rms::DBError;
+using rms::ErrorCategoryRegistry;
+
+static_assert(sizeof(CompactErrorCode) == 4U, "Error must be 32 bits");
+static_assert(sizeof(CompactValueOrError<bool>) == 8U,
+              "Result of bool must be 8 bytes");
+static_assert(sizeof(CompactValueOrError<int>) == 8U,
+              "Result of int must be 8 bytes");
+static_assert(sizeof(CompactValueOrError<void>) == 8U,
+              "Result of void must be 8 bytes");
+#if VOE_RUNTIME_CHECKS
+static_assert(!std::is_trivially_destructible<CompactValueOrError<int>>::value,
+              "Unhandled error must be detected in the dtor");
+#else
+static_assert(std::is_trivially_copyable<CompactValueOrError<int>>::value,
+              "Result of trivially copyable type must be trivially copyable");
+#endif
+
+namespace {
+
+class TestCategory : public std::error_category {
+ public:
+  const char* name() const noexcept override { return "Test"; }
+  std::string message(int value) const override {
+    return "test " + std::to_string(value);
+  }
+};
+
+CompactValueOrError<int> parse_positive(int value) {
+  if (value < 0) {
+    return std::make_error_code(std::errc::invalid_argument);
+  }
+  return value;
+}
+
+}  // namespace
+
+TEST_CASE("Predefined categories", "[CompactErrorCode]") {
+  REQUIRE(0U == ErrorCategoryRegistry::index_of(std::system_category()));
+  REQUIRE(1U == ErrorCategoryRegistry::index_of(std::generic_category()));
+  REQUIRE(&std::system_category() == &ErrorCategoryRegistry::category(0U));
+  REQUIRE(&std::generic_category() == &ErrorCategoryRegistry::category(1U));
+}
+
+TEST_CASE("Round trip", "[CompactErrorCode]") {
+  SECTION("default") {
+    CompactErrorCode const error;
+    REQUIRE_FALSE(error);
+    REQUIRE(std::error_code(0, std::system_category()) ==
+            static_cast<std::error_code>(error));
+  }
+
+  SECTION("generic") {
+    auto const code = std::make_error_code(std::errc::timed_out);
+    CompactErrorCode const error(code);
+    REQUIRE(error);
+    REQUIRE(code == static_cast<std::error_code>(error));
+    REQUIRE(code.message() == error.message());
+  }
+
+  SECTION("system") {
+    std::error_code const code(ENOENT, std::system_category());
+    REQUIRE(code == static_cast<std::error_code>(CompactErrorCode(code)));
+  }
+
+  SECTION("DBError") {
+    CompactErrorCode const error(DBError::QueryInterrupted);
+    REQUIRE(make_error_code(DBError::QueryInterrupted) ==
+            static_cast<std::error_code>(error));
+    REQUIRE("Query Interrupted" == error.message());
+  }
+
+  SECTION("BusinessServiceError") {
+    CompactErrorCode const error(BusinessServiceError::ItemNotFound);
+    REQUIRE(make_error_code(BusinessServiceError::ItemNotFound) ==
+            static_cast<std::error_code>(error));
+  }
+
+  SECTION("negative and boundary values") {
+    TestCategory const category;
+    for (int value : {-1, CompactErrorCode::MinValue,
+                      CompactErrorCode::MaxValue}) {
+      std::error_code const code(value, category);
+      CompactErrorCode const error(code);
+      REQUIRE(value == error.value());
+      REQUIRE(code == static_cast<std::error_code>(error));
+    }
+  }
+}
+
+TEST_CASE("Out of range value", "[CompactErrorCode]") {
+  TestCategory const category;
+  REQUIRE_THROWS_AS(
+      CompactErrorCode(std::error_code(CompactErrorCode::MaxValue + 1,
+                                       category)),
+      std::out_of_range);
+  REQUIRE_THROWS_AS(
+      CompactErrorCode(std::error_code(CompactErrorCode::MinValue - 1,
+                                       category)),
+      std::out_of_range);
+}
+
+TEST_CASE("Registry", "[CompactErrorCode]") {
+  auto const& db_category = make_error_code(DBError::NoOpenDB).category();
+  auto const index = ErrorCategoryRegistry::index_of(db_category);
+  REQUIRE(index >= 2U);
+  REQUIRE(index == ErrorCategoryRegistry::index_of(db_category));
+  REQUIRE(&db_category == &ErrorCategoryRegistry::category(index));
+
+  TestCategory const category;
+  auto const size = ErrorCategoryRegistry::size();
+  auto const new_index = ErrorCategoryRegistry::index_of(category);
+  REQUIRE(size == new_index);
+  REQUIRE(size + 1U == ErrorCategoryRegistry::size());
+  REQUIRE(new_index == ErrorCategoryRegistry::index_of(category));
+}
+
+TEST_CASE("Compact result", "[CompactErrorCode]") {
+  SECTION("value") {
+    auto result = parse_positive(42);
+    REQUIRE(result);
+    REQUIRE(42 == result.value());
+  }
+
+  SECTION("error") {
+    auto const result = parse_positive(-1);
+    REQUIRE_FALSE(result);
+    REQUIRE(std::make_error_code(std::errc::invalid_argument) ==
+            result.error());
+    REQUIRE(result == std::errc::invalid_argument);
+  }
+
+  SECTION("error enum") {
+    CompactValueOrError<std::string> const result = DBError::NoOpenDB;
+    REQUIRE_FALSE(result);
+    REQUIRE(result == DBError::NoOpenDB);
+  }
+
+  SECTION("then") {
+    auto result = parse_positive(1).then([](int value) {
+      return CompactValueOrError<std::string>(std::to_string(value));
+    });
+    REQUIRE(result);
+    REQUIRE("1" == result.value());
+  }
+
+  SECTION("void") {
+    CompactValueOrError<void> const success;
+    REQUIRE(success);
+    CompactValueOrError<void> const failure = CompactErrorCode(
+        std::make_error_code(std::errc::operation_canceled));
+    REQUIRE(failure == std::errc::operation_canceled);
+  }
+}
@@ -0,0 +1,24 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+// Compiled with VOE_CHECKING_OFF and -Werror=unused-result. Without runtime
+// checks a discarded result must still be reported at compile time, so the
+// build of this file is expected to fail. With VOE_DISCARD_RESULT=0 the result
+// is used and the file must compile, which rules out unrelated errors.
+#include <system_error>
+
+#include "value_or_error.h"
+
+rms::ValueOrError<int> make_result(int value) {
+  if (value < 0) {
+    return std::make_error_code(std::errc::invalid_argument);
+  }
+  return value;
+}
+
+int main() {
+#if VOE_DISCARD_RESULT
+  make_result(1);
+  return 0;
+#else
+  return make_result(1) ? 0 : 1;
+#endif
+}
@@ -0,0 +1,166 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#include "coroutine.h"
+
+#include <catch2/catch.hpp>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "db_error.h"
+#include "db_manager.h"
+#include "value_or_error.h"
+
+using rms::ValueOrError;
+
+namespace {
+
+ValueOrError<bool> is_active_admin(rms::DBManager const& db_manager) {
+  auto customer = co_await db_manager.get_active_customer();
+  bool const auth = co_await db_manager.is_auth(customer);
+  if (!auth) {
+    co_return false;
+  }
+  co_return co_await db_manager.is_admin(customer);
+}
+
+ValueOrError<std::size_t> customers_count(rms::DBManager const& db_manager,
+                                          int* steps) {
+  auto customers = db_manager.get_customers();
+  // Lvalue is borrowed, not moved out
+  auto const& names = co_await customers;
+  ++*steps;
+  auto const count = names.size();
+  REQUIRE(customers.has_value());
+  ++*steps;
+  co_return count;
+}
+
+ValueOrError<void> check_auth(rms::DBManager const& db_manager,
+                              std::string const& customer) {
+  bool const auth = co_await db_manager.is_auth(customer);
+  if (!auth) {
+    co_return std::make_error_code(std::errc::permission_denied);
+  }
+  co_return {};
+}
+
+ValueOrError<std::unique_ptr<int>> make_unique_value(int value) {
+  if (value < 0) {
+    co_return std::make_error_code(std::errc::invalid_argument);
+  }
+  co_return std::make_unique<int>(value);
+}
+
+ValueOrError<int> sum_of_unique_values(int first, int second) {
+  co_return *co_await make_unique_value(first) +
+      *co_await make_unique_value(second);
+}
+
+ValueOrError<int&> find(std::vector<int>& values, std::size_t index) {
+  if (index >= values.size()) {
+    co_return std::make_error_code(std::errc::result_out_of_range);
+  }
+  co_return values[index];
+}
+
+ValueOrError<int> increment(std::vector<int>& values, std::size_t index) {
+  int& value = co_await find(values, index);
+  co_return ++value;
+}
+
+// Awaited in the condition, so the coroutine stops inside the if statement
+ValueOrError<int> authorized(rms::DBManager const& db_manager) {
+  if (!(co_await db_manager.is_auth("John"))) {
+    co_return 1;
+  }
+  co_return 2;
+}
+
+ValueOrError<int> throwing(bool fail) {
+  co_await check_auth(rms::DBManager(), "John");
+  if (fail) {
+    throw std::runtime_error("fail");
+  }
+  co_return 1;
+}
+
+}  // namespace
+
+TEST_CASE("Coroutine", "[Coroutine]") {
+  rms::DBManager db_manager;
+
+  SECTION("values") {
+    auto result = is_active_admin(db_manager);
+    REQUIRE(result.has_value());
+    REQUIRE_FALSE(result.value());
+    REQUIRE(check_auth(db_manager, "John").has_value());
+  }
+
+  SECTION("error of awaited result") {
+    db_manager.set_current_error(rms::make_error_code(rms::DBError::NoOpenDB));
+    REQUIRE(is_active_admin(db_manager) == rms::DBError::NoOpenDB);
+    REQUIRE(check_auth(db_manager, "John") == rms::DBError::NoOpenDB);
+  }
+
+  SECTION("error is returned") {
+    REQUIRE(check_auth(db_manager, "Steve") == std::errc::permission_denied);
+  }
+
+  SECTION("lvalue is borrowed") {
+    int steps = 0;
+    REQUIRE(2U == customers_count(db_manager, &steps).value());
+    REQUIRE(2 == steps);
+
+    db_manager.set_current_error(
+        rms::make_error_code(rms::DBError::QueryInterrupted));
+    steps = 0;
+    REQUIRE(customers_count(db_manager, &steps) ==
+            rms::DBError::QueryInterrupted);
+    REQUIRE(0 == steps);
+  }
+
+  SECTION("move only value") {
+    REQUIRE(5 == sum_of_unique_values(2, 3).value());
+    REQUIRE(sum_of_unique_values(2, -3) == std::errc::invalid_argument);
+    REQUIRE(sum_of_unique_values(-2, 3) == std::errc::invalid_argument);
+  }
+
+  SECTION("reference") {
+    std::vector<int> values = {1, 2};
+    REQUIRE(3 == increment(values, 1U).value());
+    REQUIRE(3 == values[1U]);
+    REQUIRE(increment(values, 2U) == std::errc::result_out_of_range);
+  }
+
+  SECTION("await in condition") {
+    REQUIRE(2 == authorized(db_manager).value());
+    db_manager.set_current_error(rms::make_error_code(rms::DBError::NoOpenDB));
+    REQUIRE(authorized(db_manager) == rms::DBError::NoOpenDB);
+  }
+
+  SECTION("exception") {
+    REQUIRE(1 == throwing(false).value());
+    REQUIRE_THROWS_AS(throwing(true), std::runtime_error);
+  }
+}
+
+TEST_CASE("FramePool", "[Coroutine]") {
+  using rms::detail::FramePool;
+
+  SECTION("frame of the same size class is reused") {
+    void* const frame = FramePool::allocate(100U);
+    FramePool::deallocate(frame, 100U);
+    void* const other = FramePool::allocate(120U);
+    REQUIRE(frame == other);
+    FramePool::deallocate(other, 120U);
+  }
+
+  SECTION("large frames are not pooled") {
+    void* const frame = FramePool::allocate(4096U);
+    REQUIRE(frame != nullptr);
+    FramePool::deallocate(frame, 4096U);
+  }
+}
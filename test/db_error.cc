@@ -5,11 +5,6 @@
 
 using rms::DBError;
 
-template <>
-rms::util::enum_util::EnumStrings<DBError>::DataType
-    rms::util::enum_util::EnumStrings<DBError>::data = {"Success", "No Open DB",
-                                                        "Query Interrupted"};
-
 const std::error_category& rms::DBErrorCategory::get() {
   static DBErrorCategory instance;
   return instance;
@@ -27,8 +22,9 @@ std::error_code rms::make_error_code(DBError error) noexcept {
 
 const char* rms::DBErrorCategory::name() const noexcept { return "DBError"; }
 
-std::string rms::DBErrorCategory::message(int error_value) const {
-  using rms::util::enum_util::EnumToString;
+const char* rms::DBErrorCategory::message_chars(
+    int error_value) const noexcept {
+  using rms::util::enum_util::EnumToChars;
   using rms::util::enum_util::FromIntegral;
-  return EnumToString(FromIntegral<rms::DBError>(error_value));
+  return EnumToChars(FromIntegral<rms::DBError>(error_value));
 }
@@ -1,18 +1,25 @@
 // Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
 #pragma once
 
-#include <string>
 #include <system_error>
 
+#include "enum_util.h"
+#include "error_category.h"
+
 namespace rms {
 
-enum class DBError { Success, NoOpenDB, QueryInterrupted };
+#define RMS_DB_ERROR_LIST(X) \
+  X(Success, "Success")      \
+  X(NoOpenDB, "No Open DB")  \
+  X(QueryInterrupted, "Query Interrupted")
+
+RMS_ENUM_WITH_STRINGS(DBError, RMS_DB_ERROR_LIST)
 
-class DBErrorCategory : public std::error_category {
+class DBErrorCategory : public StaticMessageCategory {
  public:
   const char* name() const noexcept override;
 
-  std::string message(int error_value) const override;
+  const char* message_chars(int error_value) const noexcept override;
 
   static const std::error_category& get();
 
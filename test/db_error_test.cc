@@ -3,18 +3,42 @@
 
 #include <catch2/catch.hpp>
 
+#include <sstream>
+#include <string>
+#include <system_error>
+
+#include "compact_error.h"
 #include "enum_util.h"
+#include "value_or_error.h"
 
 using rms::DBError;
 using rms::util::enum_util::EnumToString;
 using rms::util::enum_util::ToIntegral;
 
+namespace {
+
+class LocalCategory : public rms::StaticMessageCategory {
+ public:
+  const char* name() const noexcept override { return "Local"; }
+  const char* message_chars(int) const noexcept override { return "local"; }
+};
+
+}  // namespace
+
 TEST_CASE("Enum to string", "[GeneralErrorEnum]") {
   REQUIRE("Success" == EnumToString(DBError::Success));
   REQUIRE("No Open DB" == EnumToString(DBError::NoOpenDB));
   REQUIRE("Query Interrupted" == EnumToString(DBError::QueryInterrupted));
 }
 
+TEST_CASE("Enum to chars is constant", "[GeneralErrorEnum]") {
+  using rms::util::enum_util::EnumToChars;
+  constexpr char const* message = EnumToChars(DBError::NoOpenDB);
+  REQUIRE(std::string("No Open DB") == message);
+  static_assert(EnumToChars(DBError::Success)[0] == 'S',
+                "Table of DBError needs no dynamic initialization");
+}
+
 TEST_CASE("To integral", "[GeneralErrorEnum]") {
   REQUIRE(0 == ToIntegral(DBError::Success));
   REQUIRE(1 == ToIntegral(DBError::NoOpenDB));
@@ -30,3 +54,34 @@ TEST_CASE("Makers", "[GeneralErrorEnum]") {
       make_error_code(DBError::QueryInterrupted).category().name()};
   REQUIRE("DBError" == name);
 }
+
+TEST_CASE("Static messages", "[GeneralErrorEnum]") {
+  auto const error = make_error_code(DBError::NoOpenDB);
+  auto const& category =
+      static_cast<rms::StaticMessageCategory const&>(error.category());
+  char const* const message = category.message_chars(error.value());
+  REQUIRE(std::string("No Open DB") == message);
+  REQUIRE(message == category.message_chars(error.value()));
+  REQUIRE(std::string() == category.message_chars(42));
+
+  REQUIRE(message == rms::static_message(error));
+  REQUIRE(message == rms::static_message(rms::CompactErrorCode(error)));
+  REQUIRE(nullptr == rms::static_message(
+                         std::make_error_code(std::errc::invalid_argument)));
+
+  LocalCategory const local;
+  REQUIRE(std::string("local") ==
+          rms::static_message(std::error_code(1, local)));
+  LocalCategory const locals[4];
+  for (auto const& other : locals) {
+    REQUIRE(std::string("local") ==
+            rms::static_message(std::error_code(1, other)));
+  }
+
+  std::stringstream ss;
+  ss << rms::ValueOrError<int>(DBError::QueryInterrupted) << ';'
+     << rms::ValueOrError<void>(std::errc::invalid_argument);
+  REQUIRE("Query Interrupted;" +
+              std::make_error_code(std::errc::invalid_argument).message() ==
+          ss.str());
+}
@@ -7,10 +7,44 @@
  */
 
 #include <algorithm>
-#include <iterator>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <sstream>
 #include <string>
+#include <system_error>
 #include <type_traits>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+#include "value_or_error.h"
+
+/*
+ * Declares an enum together with a constant table of its strings. LIST is
+ * an X-macro of (enumerator, string) pairs:
+ *
+ *   #define DB_ERROR_LIST(X)   \
+ *     X(Success, "Success")    \
+ *     X(NoOpenDB, "No Open DB")
+ *   RMS_ENUM_WITH_STRINGS(DBError, DB_ERROR_LIST)
+ *
+ * gives enum class DBError and constexpr enum_strings(DBError), which the
+ * functions below find by ADL. Unlike EnumStrings<T> specializations the
+ * table needs no dynamic initialization, so it can be used from other
+ * static initializers and in constant expressions. Use it in the namespace
+ * of the enum.
+ */
+#define RMS_ENUM_ENUMERATOR(enumerator, string) enumerator,
+#define RMS_ENUM_STRING(enumerator, string) string,
+#define RMS_ENUM_COUNT(enumerator, string) +1
+#define RMS_ENUM_WITH_STRINGS(Enum, LIST)                                   \
+  enum class Enum { LIST(RMS_ENUM_ENUMERATOR) };                             \
+  constexpr ::std::array<char const*, 0 LIST(RMS_ENUM_COUNT)> enum_strings( \
+      Enum) noexcept {                                                       \
+    return {{LIST(RMS_ENUM_STRING)}};                                        \
+  }
 
 namespace rms {
 namespace util {
@@ -60,13 +94,60 @@ struct Storage {
 };
 
 // Holds all strings.
-// Each enumeration must declare its own specialization.
+// Each enumeration must declare its own specialization, unless it is
+// declared with RMS_ENUM_WITH_STRINGS.
 template <typename T>
 struct EnumStrings {
   using DataType = Storage<T>;
   static DataType data;
 };
 
+namespace detail {
+
+template <typename...>
+struct make_void {
+  using type = void;
+};
+
+// void for RMS_ENUM_WITH_STRINGS enums
+template <typename T>
+using constant_strings_t =
+    typename make_void<decltype(enum_strings(T()))>::type;
+
+// Strings of the enum: EnumStrings<T> specialization
+template <typename T, typename = void>
+struct EnumTable {
+  static std::size_t size() noexcept {
+    return static_cast<std::size_t>(EnumStrings<T>::data.size);
+  }
+
+  static char const* at(std::size_t index) noexcept {
+    return EnumStrings<T>::data.data[index];
+  }
+};
+
+// RMS_ENUM_WITH_STRINGS table, a constant so at() does not build the array
+// on every call
+template <typename T>
+struct EnumTable<T, constant_strings_t<T>> {
+  using Strings = decltype(enum_strings(T()));
+
+  static constexpr Strings strings = enum_strings(T());
+
+  static constexpr std::size_t size() noexcept { return strings.size(); }
+
+  static constexpr char const* at(std::size_t index) noexcept {
+    // Const operator[] of std::array is constexpr since C++14
+    return strings[index];
+  }
+};
+
+template <typename T>
+constexpr typename EnumTable<T, constant_strings_t<T>>::Strings
+    EnumTable<T, constant_strings_t<T>>::strings;
+
+}  // namespace detail
+
 template <typename T>
 struct EnumRefHolder {
   T& enum_value;
@@ -83,10 +164,10 @@ struct EnumConstRefHolder {
 template <typename T>
 std::ostream& operator<<(std::ostream& stream,
                          EnumConstRefHolder<T> const& data) {
+  using Table = detail::EnumTable<T>;
   auto const index = ToIntegral(data.enum_value);
-  auto const data_size = EnumStrings<T>::data.size;
-  if (index >= 0 && index < data_size) {
-    stream << EnumStrings<T>::data.data[index];
+  if (index >= 0 && static_cast<std::size_t>(index) < Table::size()) {
+    stream << Table::at(static_cast<std::size_t>(index));
   }
   return stream;
 }
@@ -97,12 +178,12 @@ std::istream& operator>>(std::istream& stream, EnumRefHolder<T> const& data) {
   std::string value;
   stream >> value;
 
-  static auto begin = EnumStrings<T>::data.data;
-  static auto end = EnumStrings<T>::data.data + EnumStrings<T>::data.size;
-
-  auto find = std::find(begin, end, value);
-  if (find != end) {
-    data.enum_value = static_cast<T>(std::distance(begin, find));
+  using Table = detail::EnumTable<T>;
+  for (std::size_t i = 0U; i < Table::size(); ++i) {
+    if (value == Table::at(i)) {
+      data.enum_value = FromIntegral<T>(i);
+      break;
+    }
   }
 
   return stream;
@@ -121,20 +202,146 @@ EnumRefHolder<T> EnumFromStream(T& e) {
   return EnumRefHolder<T>(e);
 }
 
+// Constant expression for RMS_ENUM_WITH_STRINGS enums
 template <typename T>
-char const* EnumToChars(T const& e) {
+constexpr char const* EnumToChars(T const& e) {
+  using Table = detail::EnumTable<T>;
   auto const index = ToIntegral(e);
-  auto const dataSize = EnumStrings<T>::data.size;
-  if (index >= 0 && index < dataSize) {
-    return EnumStrings<T>::data.data[index];
+  if (index >= 0 && static_cast<std::size_t>(index) < Table::size()) {
+    return Table::at(static_cast<std::size_t>(index));
   }
   return "";
 }
 
+#if __cplusplus >= 201703L
+template <typename T>
+constexpr std::string_view EnumToStringView(T const& e) {
+  return EnumToChars(e);
+}
+#endif
+
+namespace detail {
+
+// FNV-1a
+constexpr std::uint64_t hash_of(char const* name, std::size_t size) noexcept {
+  std::uint64_t hash = 14695981039346656037ULL;
+  for (std::size_t i = 0U; i < size; ++i) {
+    hash = (hash ^ static_cast<unsigned char>(name[i])) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+constexpr std::size_t length_of(char const* name) noexcept {
+  std::size_t size = 0U;
+  while (name[size] != '\0') {
+    ++size;
+  }
+  return size;
+}
+
+struct IndexEntry {
+  std::uint64_t hash;
+  char const* name;
+  std::size_t size;
+  int index;
+};
+
+// Entries of the strings sorted by hash, equal hashes by index
+template <std::size_t Size>
+struct SortedIndex {
+  IndexEntry entries[Size == 0U ? 1U : Size];
+};
+
+template <typename T>
+constexpr SortedIndex<EnumTable<T>::size()> make_index() noexcept {
+  using Table = EnumTable<T>;
+  SortedIndex<Table::size()> index{};
+  for (std::size_t i = 0U; i < Table::size(); ++i) {
+    auto const* name = Table::at(i);
+    auto const size = length_of(name);
+    IndexEntry const entry{hash_of(name, size), name, size,
+                           static_cast<int>(i)};
+    auto j = i;
+    for (; j > 0U && index.entries[j - 1U].hash > entry.hash; --j) {
+      index.entries[j] = index.entries[j - 1U];
+    }
+    index.entries[j] = entry;
+  }
+  return index;
+}
+
+}  // namespace detail
+
+// Lookup of the strings of EnumStrings<T> specializations: a linear scan,
+// the strings are only known after dynamic initialization.
+template <typename T, typename = void>
+struct EnumIndex {
+  // Index of the first string equal to the name, -1 if there is none
+  static int find(char const* name, std::size_t size) noexcept {
+    using Table = detail::EnumTable<T>;
+    for (std::size_t i = 0U; i < Table::size(); ++i) {
+      auto const* string = Table::at(i);
+      if (std::strlen(string) == size && std::memcmp(string, name, size) == 0) {
+        return static_cast<int>(i);
+      }
+    }
+    return -1;
+  }
+};
+
+// RMS_ENUM_WITH_STRINGS table: the hashes of the strings sorted at compile
+// time. Lookup hashes the name once and binary searches it, so it needs no
+// initialization on first use and does not allocate.
+template <typename T>
+struct EnumIndex<T, detail::constant_strings_t<T>> {
+  using Index = detail::SortedIndex<detail::EnumTable<T>::size()>;
+
+  static constexpr Index value = detail::make_index<T>();
+
+  static int find(char const* name, std::size_t size) noexcept {
+    auto const hash = detail::hash_of(name, size);
+    auto const* const end = value.entries + detail::EnumTable<T>::size();
+    auto const* entry = std::lower_bound(
+        value.entries, end, hash,
+        [](detail::IndexEntry const& lhs, std::uint64_t rhs) {
+          return lhs.hash < rhs;
+        });
+    for (; entry != end && entry->hash == hash; ++entry) {
+      if (entry->size == size && std::memcmp(entry->name, name, size) == 0) {
+        return entry->index;
+      }
+    }
+    return -1;
+  }
+};
+
+template <typename T>
+constexpr typename EnumIndex<T, detail::constant_strings_t<T>>::Index
+    EnumIndex<T, detail::constant_strings_t<T>>::value;
+
 #if defined(__clang__)
 #pragma clang diagnostic pop
 #endif
 
+// Enum value with the name, std::errc::invalid_argument for unknown names.
+// Does not allocate, the name needs no terminating zero.
+template <typename T>
+ValueOrError<T> EnumFromChars(char const* name, std::size_t size) {
+  auto const index = EnumIndex<T>::find(name, size);
+  if (index < 0) {
+    return std::make_error_code(std::errc::invalid_argument);
+  }
+  // in_place: error enums such as DBError are values here, not errors
+  return ValueOrError<T>(in_place, FromIntegral<T>(index));
+}
+
+#if __cplusplus >= 201703L
+template <typename T>
+ValueOrError<T> EnumFromChars(std::string_view name) {
+  return EnumFromChars<T>(name.data(), name.size());
+}
+#endif
+
 template <typename T>
 std::string EnumToString(T const& e) {
   return std::string(EnumToChars<T>(e));
@@ -1,8 +1,12 @@
 // Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
 #include "enum_util.h"
 
+#include <array>
 #include <catch2/catch.hpp>
+#include <cstddef>
 #include <sstream>
+#include <string>
+#include <utility>
 
 namespace {
 
@@ -16,8 +20,59 @@ enum class EnumCustomInit {
   Bar,
 };
 
+#define ENUM_CONSTANT_LIST(X) \
+  X(Foo, "FooConst")          \
+  X(Bar, "BarConst")
+
+RMS_ENUM_WITH_STRINGS(EnumConstant, ENUM_CONSTANT_LIST)
+
+constexpr bool equal(char const* lhs, char const* rhs) {
+  return *lhs == *rhs && (*lhs == '\0' || equal(lhs + 1, rhs + 1));
+}
+
+enum class EnumLarge : int {};
+
+constexpr std::size_t EnumLargeSize = 300U;
+
+// Names with a common prefix: "Large0", "Large1", ...
+struct LargeNames {
+  char names[EnumLargeSize][sizeof("Large299")];
+};
+
+constexpr LargeNames make_large_names() noexcept {
+  LargeNames result{};
+  for (std::size_t i = 0U; i < EnumLargeSize; ++i) {
+    auto* name = result.names[i];
+    for (auto const* prefix = "Large"; *prefix != '\0'; ++prefix) {
+      *name++ = *prefix;
+    }
+    std::size_t digits = 1U;
+    for (auto rest = i / 10U; rest != 0U; rest /= 10U) {
+      ++digits;
+    }
+    for (auto rest = i; digits != 0U; rest /= 10U) {
+      name[--digits] = static_cast<char>('0' + rest % 10U);
+    }
+  }
+  return result;
+}
+
+constexpr LargeNames large_names = make_large_names();
+
+template <std::size_t... Indices>
+constexpr std::array<char const*, EnumLargeSize> large_strings(
+    std::index_sequence<Indices...>) noexcept {
+  return {{large_names.names[Indices]...}};
+}
+
+constexpr std::array<char const*, EnumLargeSize> enum_strings(
+    EnumLarge) noexcept {
+  return large_strings(std::make_index_sequence<EnumLargeSize>());
+}
+
 }  // namespace
 
+using rms::util::enum_util::EnumFromChars;
 using rms::util::enum_util::EnumFromStream;
 using rms::util::enum_util::EnumStrings;
 using rms::util::enum_util::EnumToChars;
@@ -89,3 +144,62 @@ TEST_CASE("To string for invalid enum item", "[EnumUtil]") {
   REQUIRE(EnumToString(FromIntegral<EnumCustomInit>(3)).empty());
   REQUIRE(std::string{EnumToChars(FromIntegral<EnumCustomInit>(3))}.empty());
 }
+
+TEST_CASE("From chars", "[EnumUtil]") {
+  REQUIRE(EnumDefaultInit::Bar ==
+          EnumFromChars<EnumDefaultInit>("BarDef", 6U).value());
+  REQUIRE(EnumCustomInit::Foo ==
+          EnumFromChars<EnumCustomInit>("FooCustom", 9U).value());
+  REQUIRE(FromIntegral<EnumCustomInit>(0) ==
+          EnumFromChars<EnumCustomInit>("Dummy", 5U).value());
+
+  SECTION("name is not zero terminated") {
+    std::string const line = "FooDef,BarDef";
+    REQUIRE(EnumDefaultInit::Foo ==
+            EnumFromChars<EnumDefaultInit>(line.data(), 6U).value());
+    REQUIRE(EnumDefaultInit::Bar ==
+            EnumFromChars<EnumDefaultInit>(line.data() + 7U, 6U).value());
+  }
+
+  SECTION("unknown name") {
+    REQUIRE(EnumFromChars<EnumDefaultInit>("Baz", 3U) ==
+            std::errc::invalid_argument);
+    REQUIRE(EnumFromChars<EnumDefaultInit>("BarDef", 3U) ==
+            std::errc::invalid_argument);
+    REQUIRE(EnumFromChars<EnumDefaultInit>("BarDefX", 7U) ==
+            std::errc::invalid_argument);
+    REQUIRE(EnumFromChars<EnumDefaultInit>("", 0U) ==
+            std::errc::invalid_argument);
+  }
+
+  SECTION("hundreds of names") {
+    for (std::size_t i = 0U; i < EnumLargeSize; ++i) {
+      std::string const name = "Large" + std::to_string(i);
+      REQUIRE(FromIntegral<EnumLarge>(i) ==
+              EnumFromChars<EnumLarge>(name.data(), name.size()).value());
+    }
+    REQUIRE(EnumFromChars<EnumLarge>("Large300", 8U) ==
+            std::errc::invalid_argument);
+  }
+}
+
+TEST_CASE("Constant strings", "[EnumUtil]") {
+  static_assert(equal("FooConst", EnumToChars(EnumConstant::Foo)),
+                "EnumToChars is a constant expression");
+  static_assert(equal("", EnumToChars(FromIntegral<EnumConstant>(2))),
+                "Invalid enum item has empty string");
+
+  std::stringstream sstream;
+  sstream << EnumToStream(EnumConstant::Foo) << " "
+          << EnumToStream(EnumConstant::Bar);
+  REQUIRE(std::string{"FooConst BarConst"} == sstream.str());
+
+  auto value = EnumConstant::Foo;
+  sstream >> EnumFromStream(value) >> EnumFromStream(value);
+  REQUIRE(value == EnumConstant::Bar);
+
+  REQUIRE(EnumConstant::Bar ==
+          EnumFromChars<EnumConstant>("BarConst", 8U).value());
+  REQUIRE(EnumFromChars<EnumConstant>("FooDef", 6U) ==
+          std::errc::invalid_argument);
+}
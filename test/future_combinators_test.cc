@@ -0,0 +1,188 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#include "future_combinators.h"
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <system_error>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "db_error.h"
+#include "db_manager.h"
+#include "future.h"
+#include "thread_pool.h"
+#include "value_or_error.h"
+
+using rms::Future;
+using rms::Promise;
+using rms::ValueOrError;
+
+namespace {
+
+// Value without a default constructor
+class Id {
+ public:
+  explicit Id(int value) : m_value(value) {}
+
+  int value() const noexcept { return m_value; }
+
+ private:
+  int m_value;
+};
+
+}  // namespace
+
+TEST_CASE("WhenAll", "[Future]") {
+  SECTION("all values") {
+    Promise<int> first;
+    Promise<std::string> second;
+    Promise<Id> third;
+    auto all = rms::when_all(first.get_future(), second.get_future(),
+                             third.get_future());
+    second.set_value("John");
+    third.set_value(3);
+    REQUIRE_FALSE(all.is_ready());
+    first.set_value(1);
+    REQUIRE(all.is_ready());
+    auto result = std::move(all).get();
+    REQUIRE(1 == std::get<0>(result.value()));
+    REQUIRE("John" == std::get<1>(result.value()));
+    REQUIRE(3 == std::get<2>(result.value()).value());
+  }
+
+  SECTION("first error does not wait for the rest") {
+    Promise<int> first;
+    Promise<int> second;
+    Promise<int> third;
+    auto all = rms::when_all(first.get_future(), second.get_future(),
+                             third.get_future());
+    second.set_error(rms::DBError::QueryInterrupted);
+    REQUIRE(all.is_ready());
+    third.set_error(rms::DBError::NoOpenDB);
+    first.set_value(1);
+    REQUIRE(std::move(all).get() == rms::DBError::QueryInterrupted);
+  }
+
+  SECTION("vector") {
+    std::vector<Promise<Id>> promises(4U);
+    std::vector<Future<Id>> futures;
+    for (auto& promise : promises) {
+      futures.push_back(promise.get_future());
+    }
+    auto all = rms::when_all(std::move(futures));
+    for (int i = 3; i >= 0; --i) {
+      promises[static_cast<std::size_t>(i)].set_value(i);
+    }
+    auto result = std::move(all).get();
+    REQUIRE(4U == result.value().size());
+    for (std::size_t i = 0U; i < 4U; ++i) {
+      REQUIRE(static_cast<int>(i) == result.value()[i].value());
+    }
+  }
+
+  SECTION("vector with error") {
+    std::vector<Future<int>> futures;
+    futures.push_back(rms::make_ready_future(ValueOrError<int>(1)));
+    futures.push_back(rms::make_ready_future(
+        ValueOrError<int>(std::make_error_code(std::errc::timed_out))));
+    REQUIRE(rms::when_all(std::move(futures)).get() == std::errc::timed_out);
+  }
+
+  SECTION("empty vector") {
+    auto result = rms::when_all(std::vector<Future<int>>()).get();
+    REQUIRE(result.value().empty());
+  }
+}
+
+TEST_CASE("WhenAny", "[Future]") {
+  SECTION("first value") {
+    Promise<int> first;
+    Promise<int> second;
+    auto any = rms::when_any(first.get_future(), second.get_future());
+    second.set_value(2);
+    REQUIRE(any.is_ready());
+    first.set_value(1);
+    REQUIRE(2 == std::move(any).get().value());
+  }
+
+  SECTION("errors are skipped") {
+    Promise<std::string> first;
+    Promise<std::string> second;
+    auto any = rms::when_any(first.get_future(), second.get_future());
+    first.set_error(rms::DBError::NoOpenDB);
+    REQUIRE_FALSE(any.is_ready());
+    second.set_value("Steve");
+    REQUIRE("Steve" == std::move(any).get().value());
+  }
+
+  SECTION("all errors give the error of the first input") {
+    Promise<int> first;
+    Promise<int> second;
+    Promise<int> third;
+    auto any = rms::when_any(first.get_future(), second.get_future(),
+                             third.get_future());
+    third.set_error(std::make_error_code(std::errc::timed_out));
+    first.set_error(rms::DBError::QueryInterrupted);
+    REQUIRE_FALSE(any.is_ready());
+    second.set_error(rms::DBError::NoOpenDB);
+    REQUIRE(std::move(any).get() == rms::DBError::QueryInterrupted);
+  }
+
+  SECTION("vector") {
+    std::vector<Future<Id>> futures;
+    futures.push_back(rms::make_ready_future(
+        ValueOrError<Id>(std::make_error_code(std::errc::timed_out))));
+    futures.push_back(rms::make_ready_future(ValueOrError<Id>(Id(5))));
+    REQUIRE(5 == rms::when_any(std::move(futures)).get().value().value());
+  }
+
+  SECTION("empty vector") {
+    REQUIRE(rms::when_any(std::vector<Future<int>>()).get() ==
+            std::errc::invalid_argument);
+  }
+}
+
+TEST_CASE("WhenAllOnThreadPool", "[Future]") {
+  rms::ThreadPool pool(3U);
+  rms::DBManager db_manager;
+
+  SECTION("lookups") {
+    for (int i = 0; i < 100; ++i) {
+      auto lookups = rms::when_all(
+          rms::async(pool,
+                     [&db_manager] { return db_manager.is_auth("John"); }),
+          rms::async(pool,
+                     [&db_manager] { return db_manager.is_admin("Steve"); }),
+          rms::async(pool,
+                     [&db_manager] { return db_manager.get_customers(); }));
+      auto result = std::move(lookups).get();
+      REQUIRE(result);
+      REQUIRE(std::get<0>(result.value()));
+      REQUIRE(std::get<1>(result.value()));
+      REQUIRE(std::get<2>(result.value()).size() > 0U);
+    }
+  }
+
+  SECTION("lookups fail") {
+    db_manager.set_current_error(rms::make_error_code(rms::DBError::NoOpenDB));
+    auto any = rms::when_any(
+        rms::async(pool,
+                   [&db_manager] { return db_manager.is_auth("John"); }),
+        rms::async(pool,
+                   [&db_manager] { return db_manager.is_admin("John"); }));
+    REQUIRE(std::move(any).get() == rms::DBError::NoOpenDB);
+  }
+
+  SECTION("vector") {
+    std::vector<Future<int>> futures;
+    for (int i = 0; i < 64; ++i) {
+      futures.push_back(
+          rms::async(pool, [i] { return ValueOrError<int>(i); }));
+    }
+    auto result = rms::when_all(std::move(futures)).get();
+    REQUIRE(64U == result.value().size());
+    REQUIRE(63 == result.value().back());
+  }
+}
@@ -0,0 +1,183 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#include "future.h"
+
+#include <catch2/catch.hpp>
+
+#include <future>
+#include <new>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include "db_error.h"
+#include "db_manager.h"
+#include "thread_pool.h"
+#include "value_or_error.h"
+
+using rms::Future;
+using rms::InlineExecutor;
+using rms::Promise;
+using rms::ValueOrError;
+
+namespace {
+
+ValueOrError<std::size_t> length(std::string const& text) {
+  if (text.empty()) {
+    return std::make_error_code(std::errc::invalid_argument);
+  }
+  return text.size();
+}
+
+struct FailingExecutor {
+  template <typename F>
+  void post(F&&) {
+    throw std::bad_alloc();
+  }
+};
+
+}  // namespace
+
+TEST_CASE("Future", "[Future]") {
+  InlineExecutor inline_executor;
+
+  SECTION("value set before get") {
+    Promise<int> promise;
+    auto future = promise.get_future();
+    REQUIRE(future.valid());
+    REQUIRE_FALSE(future.is_ready());
+    promise.set_value(7);
+    REQUIRE(future.is_ready());
+    REQUIRE(7 == std::move(future).get().value());
+    REQUIRE_FALSE(future.valid());
+  }
+
+  SECTION("error") {
+    Promise<std::string> promise;
+    auto future = promise.get_future();
+    promise.set_error(rms::DBError::QueryInterrupted);
+    REQUIRE(std::move(future).get() == rms::DBError::QueryInterrupted);
+  }
+
+  SECTION("continuation attached before the result") {
+    Promise<std::string> promise;
+    auto future = promise.get_future().then_async(inline_executor, length);
+    REQUIRE_FALSE(future.is_ready());
+    promise.set_value("John");
+    REQUIRE(future.is_ready());
+    REQUIRE(4U == std::move(future).get().value());
+  }
+
+  SECTION("continuation attached after the result") {
+    Promise<std::string> promise;
+    auto future = promise.get_future();
+    promise.set_value("Steve");
+    auto next = std::move(future).then_async(inline_executor, length);
+    REQUIRE_FALSE(future.valid());
+    REQUIRE(5U == std::move(next).get().value());
+  }
+
+  SECTION("error skips continuations") {
+    bool called = false;
+    auto future =
+        rms::make_ready_future(ValueOrError<std::string>(
+                                   std::make_error_code(std::errc::timed_out)))
+            .then_async(inline_executor,
+                        [&called](std::string const& text) {
+                          called = true;
+                          return length(text);
+                        })
+            .then_async(inline_executor, [](std::size_t size) {
+              return ValueOrError<bool>(size > 2U);
+            });
+    REQUIRE(std::move(future).get() == std::errc::timed_out);
+    REQUIRE_FALSE(called);
+  }
+
+  SECTION("broken promise") {
+    Future<int> future;
+    {
+      Promise<int> promise;
+      future = promise.get_future();
+    }
+    REQUIRE(std::move(future).get() == std::future_errc::broken_promise);
+  }
+
+  SECTION("promise destroyed without future") {
+    { Promise<std::string> promise; }
+    {
+      Promise<std::string> promise;
+      promise.set_error(std::make_error_code(std::errc::timed_out));
+    }
+  }
+
+  SECTION("dropped future of broken promise") {
+    Promise<std::string> promise;
+    { auto future = promise.get_future(); }
+    Promise<std::string> other;
+    promise = std::move(other);
+  }
+
+  SECTION("on result") {
+    Promise<void> promise;
+    bool done = false;
+    promise.get_future().on_result(
+        [&done](ValueOrError<void>&& result) noexcept { done = !!result; });
+    REQUIRE_FALSE(done);
+    promise.set_value();
+    REQUIRE(done);
+  }
+
+  SECTION("broken promise runs continuation") {
+    bool broken = false;
+    {
+      Promise<int> promise;
+      promise.get_future().on_result(
+          [&broken](ValueOrError<int>&& result) noexcept {
+            broken = result == std::future_errc::broken_promise;
+          });
+    }
+    REQUIRE(broken);
+  }
+
+  SECTION("failed post breaks promise") {
+    FailingExecutor failing_executor;
+    auto future = rms::make_ready_future(ValueOrError<std::string>("Steve"))
+                      .then_async(failing_executor, length);
+    REQUIRE(std::move(future).get() == std::future_errc::broken_promise);
+  }
+
+  SECTION("chain on thread pool") {
+    rms::ThreadPool pool(2U);
+    rms::DBManager db_manager;
+    Promise<std::string> promise;
+    auto is_auth = promise.get_future().then_async(
+        pool, [&db_manager](std::string const& customer) {
+          return db_manager.is_auth(customer);
+        });
+    std::thread producer([&promise, &db_manager] {
+      promise.set_result(db_manager.get_active_customer());
+    });
+    // Waits for the continuation which runs on the pool
+    REQUIRE(std::move(is_auth).get().value());
+    producer.join();
+  }
+
+  SECTION("many chains on thread pool") {
+    rms::ThreadPool pool(3U);
+    for (int i = 0; i < 200; ++i) {
+      Promise<int> promise;
+      auto future = promise.get_future()
+                        .then_async(pool,
+                                    [](int value) {
+                                      return ValueOrError<int>(value + 1);
+                                    })
+                        .then_async(pool, [](int value) {
+                          return ValueOrError<int>(value * 2);
+                        });
+      std::thread producer([&promise, i] { promise.set_value(i); });
+      REQUIRE((i + 1) * 2 == std::move(future).get().value());
+      producer.join();
+    }
+  }
+}
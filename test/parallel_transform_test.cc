@@ -0,0 +1,136 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#include "parallel_transform.h"
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "business_service.h"
+#include "business_service_error.h"
+#include "db_manager.h"
+#include "thread_pool.h"
+#include "value_or_error.h"
+
+using rms::ThreadPool;
+using rms::TransformMode;
+using rms::ValueOrError;
+
+namespace {
+
+std::vector<int> make_inputs(int size) {
+  std::vector<int> inputs(static_cast<std::size_t>(size));
+  std::iota(inputs.begin(), inputs.end(), 0);
+  return inputs;
+}
+
+// Negative inputs fail
+ValueOrError<int> square(int value) {
+  if (value < 0) {
+    return std::make_error_code(std::errc::invalid_argument);
+  }
+  return value * value;
+}
+
+}  // namespace
+
+TEST_CASE("Parallel transform", "[ParallelTransform]") {
+  ThreadPool pool(3U);
+
+  SECTION("all values") {
+    auto const inputs = make_inputs(1000);
+    std::vector<ValueOrError<int>> out;
+    REQUIRE(rms::parallel_transform(inputs, square, pool, out));
+    REQUIRE(inputs.size() == out.size());
+    for (std::size_t i = 0U; i < out.size(); ++i) {
+      REQUIRE(inputs[i] * inputs[i] == out[i].value());
+    }
+  }
+
+  SECTION("empty range") {
+    std::vector<int> inputs;
+    std::vector<ValueOrError<int>> out(3U);
+    REQUIRE(rms::parallel_transform(inputs, square, pool, out));
+    REQUIRE(out.empty());
+  }
+
+  SECTION("all mode transforms every element") {
+    auto inputs = make_inputs(500);
+    inputs[100] = -1;
+    inputs[400] = -2;
+    std::vector<ValueOrError<int>> out;
+    auto const status = rms::parallel_transform(inputs, square, pool, out,
+                                                TransformMode::All);
+    REQUIRE(status == std::errc::invalid_argument);
+    std::size_t errors = 0U;
+    for (auto const& result : out) {
+      REQUIRE((result || result.error() == std::errc::invalid_argument));
+      errors += result ? 0U : 1U;
+    }
+    REQUIRE(2U == errors);
+  }
+
+  SECTION("first error mode stops other workers") {
+    auto const inputs = make_inputs(100000);
+    std::atomic<std::size_t> calls{0U};
+    std::vector<ValueOrError<int>> out;
+    auto const status = rms::parallel_transform(
+        inputs,
+        [&calls](int value) -> ValueOrError<int> {
+          calls.fetch_add(1U, std::memory_order_relaxed);
+          if (value == 10) {
+            return std::make_error_code(std::errc::timed_out);
+          }
+          return value;
+        },
+        pool, out, TransformMode::FirstError);
+    REQUIRE(status == std::errc::timed_out);
+    REQUIRE(calls.load() < inputs.size());
+    REQUIRE(out[10] == std::errc::timed_out);
+    std::size_t skipped = 0U;
+    for (auto& result : out) {
+      result.ignore();
+      skipped += result.has_value() || result.error() ? 0U : 1U;
+    }
+    REQUIRE(inputs.size() - calls.load() == skipped);
+  }
+
+  SECTION("collected values") {
+    auto values = rms::parallel_transform(make_inputs(100), square, pool);
+    REQUIRE(values);
+    REQUIRE(100U == values.value().size());
+    REQUIRE(99 * 99 == values.value().back());
+
+    auto inputs = make_inputs(100);
+    inputs[50] = -1;
+    REQUIRE(rms::parallel_transform(inputs, square, pool) ==
+            std::errc::invalid_argument);
+  }
+
+  SECTION("pool with one thread") {
+    ThreadPool single(1U);
+    auto values = rms::parallel_transform(make_inputs(10), square, single);
+    REQUIRE(81 == values.value().back());
+  }
+
+  SECTION("customers by ids") {
+    rms::DBManager db_manager;
+    rms::BusinessService business_service(db_manager);
+    auto const get_customer = [&business_service](std::uint32_t id) {
+      return business_service.get_customer_by_id(id);
+    };
+
+    std::vector<std::uint32_t> ids = {1U, 0U, 1U};
+    auto customers = rms::parallel_transform(ids, get_customer, pool);
+    REQUIRE(std::vector<std::string>{"Steve", "John", "Steve"} ==
+            customers.value());
+
+    ids.push_back(7U);
+    REQUIRE(rms::parallel_transform(ids, get_customer, pool) ==
+            rms::BusinessServiceError::ItemNotFound);
+  }
+}
@@ -0,0 +1,152 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#include "pipeline.h"
+
+#include <catch2/catch.hpp>
+
+#include <memory>
+#include <string>
+#include <system_error>
+
+#include "value_or_error.h"
+
+using rms::ValueOrError;
+using rms::pipeline::map;
+using rms::pipeline::pipe;
+using rms::pipeline::then;
+
+namespace {
+
+// Counts copies and moves of the value passed through the pipeline
+class Tracked {
+ public:
+  explicit Tracked(int value) : m_value(value) {}
+
+  Tracked(Tracked const& other) : m_value(other.m_value) { ++Copies; }
+
+  Tracked(Tracked&& other) noexcept : m_value(other.m_value) { ++Moves; }
+
+  Tracked& operator=(Tracked const&) = delete;
+  Tracked& operator=(Tracked&&) = delete;
+
+  ~Tracked() = default;
+
+  int value() const { return m_value; }
+
+  static std::size_t Copies;
+  static std::size_t Moves;
+
+ private:
+  int m_value;
+};
+
+std::size_t Tracked::Copies = 0U;
+std::size_t Tracked::Moves = 0U;
+
+ValueOrError<int> parse(std::string const& text) {
+  if (text.empty()) {
+    return std::make_error_code(std::errc::invalid_argument);
+  }
+  return std::stoi(text);
+}
+
+ValueOrError<int> check_positive(int value) {
+  if (value <= 0) {
+    return std::make_error_code(std::errc::result_out_of_range);
+  }
+  return value;
+}
+
+}  // namespace
+
+TEST_CASE("Pipeline", "[Pipeline]") {
+  SECTION("stages run in order") {
+    auto result = (pipe(ValueOrError<std::string>(std::string("21"))) |
+                   then(parse) | map([](int value) { return value * 2; }) |
+                   then(check_positive) |
+                   map([](int value) { return std::to_string(value); }))
+                      .run();
+    static_assert(
+        std::is_same<ValueOrError<std::string>, decltype(result)>::value,
+        "Result must be of the type of the last stage");
+    REQUIRE(result);
+    REQUIRE("42" == result.value());
+  }
+
+  SECTION("source error skips all stages") {
+    bool called = false;
+    auto result = (pipe(ValueOrError<int>(
+                       std::make_error_code(std::errc::timed_out))) |
+                   map([&called](int value) {
+                     called = true;
+                     return value;
+                   }))
+                      .run();
+    REQUIRE_FALSE(called);
+    REQUIRE(result == std::errc::timed_out);
+  }
+
+  SECTION("first error stops the pipeline") {
+    bool called = false;
+    auto result = (pipe(ValueOrError<int>(-1)) | then(check_positive) |
+                   map([&called](int value) {
+                     called = true;
+                     return value;
+                   }))
+                      .run();
+    REQUIRE_FALSE(called);
+    REQUIRE(result == std::errc::result_out_of_range);
+  }
+
+  SECTION("no stages") {
+    ValueOrError<int> source(5);
+    auto result = pipe(source).run();
+    REQUIRE(5 == result.value());
+  }
+
+  SECTION("lvalue source is not moved") {
+    ValueOrError<std::string> source(std::string("text"));
+    auto const size = [](std::string const& text) { return text.size(); };
+    auto result = (pipe(source) | map(size)).run();
+    REQUIRE(4U == result.value());
+    REQUIRE("text" == source.value());
+  }
+
+  SECTION("rvalue source is owned") {
+    auto pipeline = pipe(ValueOrError<std::string>(std::string("21"))) |
+                    then(parse) | map([](int value) { return value * 2; });
+    auto result = std::move(pipeline).run();
+    REQUIRE(42 == result.value());
+  }
+
+  SECTION("const source") {
+    ValueOrError<int> const source(3);
+    auto result = (pipe(source) | then(check_positive)).run();
+    REQUIRE(3 == result.value());
+  }
+
+  SECTION("value is moved between stages") {
+    Tracked::Copies = 0U;
+    Tracked::Moves = 0U;
+    auto const pass = [](Tracked&& value) { return std::move(value); };
+    auto result =
+        (pipe(ValueOrError<Tracked>(rms::in_place, 7)) | map(pass) |
+         then([](Tracked&& value) {
+           return ValueOrError<Tracked>(std::move(value));
+         }) |
+         map(pass))
+            .run();
+    REQUIRE(7 == result.value().value());
+    REQUIRE(0U == Tracked::Copies);
+  }
+
+  SECTION("move only value") {
+    auto result =
+        (pipe(ValueOrError<std::unique_ptr<int>>(std::make_unique<int>(1))) |
+         map([](std::unique_ptr<int>&& value) {
+           ++*value;
+           return std::move(value);
+         }))
+            .run();
+    REQUIRE(2 == *result.value());
+  }
+}
@@ -0,0 +1,211 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#include "task.h"
+
+#include <catch2/catch.hpp>
+
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include "db_error.h"
+#include "db_manager.h"
+#include "future.h"
+#include "thread_pool.h"
+#include "value_or_error.h"
+
+using rms::Task;
+using rms::ValueOrError;
+
+// Constant stack needs symmetric transfer compiled to tail calls, which
+// sanitizer builds don't do, so deep chains overflow the stack there
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define SANITIZED_BUILD 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer)
+#define SANITIZED_BUILD 1
+#endif
+#endif
+#ifndef SANITIZED_BUILD
+#define SANITIZED_BUILD 0
+#endif
+
+namespace {
+
+Task<std::string> get_active_customer(rms::DBManager const& db_manager,
+                                      int* steps) {
+  ++*steps;
+  co_return db_manager.get_active_customer();
+}
+
+Task<bool> is_auth_customer(rms::DBManager const& db_manager, int* steps) {
+  auto customer = co_await get_active_customer(db_manager, steps);
+  ++*steps;
+  auto const auth = co_await db_manager.is_auth(customer);
+  ++*steps;
+  co_return auth;
+}
+
+Task<std::size_t> customers_count(rms::DBManager const& db_manager) {
+  auto customers = db_manager.get_customers();
+  auto const& names = co_await customers;
+  co_return names.size();
+}
+
+// Both results and tasks awaited in the condition of an if statement
+Task<int> auth_level(rms::DBManager const& db_manager) {
+  if (co_await db_manager.is_auth("John")) {
+    co_return 2;
+  }
+  co_return 1;
+}
+
+Task<int> customer_auth_level(rms::DBManager const& db_manager) {
+  int steps = 0;
+  if (co_await is_auth_customer(db_manager, &steps)) {
+    co_return 2;
+  }
+  co_return 1;
+}
+
+Task<int> depth(int levels) {
+  if (levels == 0) {
+    co_return 0;
+  }
+  co_return 1 + co_await depth(levels - 1);
+}
+
+Task<int> failing_depth(int levels, int* resumed) {
+  if (levels == 0) {
+    co_return std::make_error_code(std::errc::timed_out);
+  }
+  int const value = co_await failing_depth(levels - 1, resumed);
+  ++*resumed;
+  co_return value + 1;
+}
+
+Task<void> check(bool ok) {
+  if (!ok) {
+    co_return std::make_error_code(std::errc::permission_denied);
+  }
+  co_return {};
+}
+
+Task<int> checked(bool ok) {
+  co_await check(ok);
+  co_return 1;
+}
+
+Task<int> throwing() {
+  co_await check(true);
+  throw std::runtime_error("fail");
+}
+
+Task<std::string> catching() {
+  try {
+    co_await throwing();
+  } catch (std::runtime_error const& error) {
+    co_return std::string(error.what());
+  }
+  co_return std::string();
+}
+
+Task<bool> is_admin_on_pool(rms::ThreadPool& pool,
+                            rms::DBManager const& db_manager,
+                            std::thread::id* thread) {
+  co_await rms::schedule(pool);
+  *thread = std::this_thread::get_id();
+  int steps = 0;
+  auto customer = co_await get_active_customer(db_manager, &steps);
+  co_return co_await db_manager.is_admin(customer);
+}
+
+}  // namespace
+
+TEST_CASE("Task", "[Task]") {
+  rms::DBManager db_manager;
+
+  SECTION("lazy start") {
+    int steps = 0;
+    auto task = is_auth_customer(db_manager, &steps);
+    REQUIRE(task.valid());
+    REQUIRE(0 == steps);
+    auto future = rms::start(std::move(task));
+    REQUIRE_FALSE(task.valid());
+    REQUIRE(future.is_ready());
+    REQUIRE(std::move(future).get().value());
+    REQUIRE(3 == steps);
+  }
+
+  SECTION("not started") {
+    int steps = 0;
+    {
+      auto task = is_auth_customer(db_manager, &steps);
+    }
+    REQUIRE(0 == steps);
+  }
+
+  SECTION("error of awaited task skips the rest") {
+    db_manager.set_current_error(rms::make_error_code(rms::DBError::NoOpenDB));
+    int steps = 0;
+    REQUIRE(rms::start(is_auth_customer(db_manager, &steps)).get() ==
+            rms::DBError::NoOpenDB);
+    REQUIRE(1 == steps);
+  }
+
+  SECTION("lvalue result") {
+    REQUIRE(2U == rms::start(customers_count(db_manager)).get().value());
+  }
+
+  SECTION("void") {
+    REQUIRE(1 == rms::start(checked(true)).get().value());
+    REQUIRE(rms::start(checked(false)).get() == std::errc::permission_denied);
+  }
+
+  SECTION("await in condition") {
+    REQUIRE(2 == rms::start(auth_level(db_manager)).get().value());
+    REQUIRE(2 == rms::start(customer_auth_level(db_manager)).get().value());
+    db_manager.set_current_error(rms::make_error_code(rms::DBError::NoOpenDB));
+    REQUIRE(rms::start(auth_level(db_manager)).get() == rms::DBError::NoOpenDB);
+    REQUIRE(rms::start(customer_auth_level(db_manager)).get() ==
+            rms::DBError::NoOpenDB);
+  }
+
+#if !SANITIZED_BUILD
+  SECTION("deep chain runs in constant stack") {
+    REQUIRE(100000 == rms::start(depth(100000)).get().value());
+  }
+#endif
+
+  SECTION("error of deep chain") {
+    int resumed = 0;
+    REQUIRE(rms::start(failing_depth(1000, &resumed)).get() ==
+            std::errc::timed_out);
+    REQUIRE(0 == resumed);
+  }
+
+  SECTION("exception") {
+    REQUIRE("fail" == rms::start(catching()).get().value());
+    REQUIRE(rms::start(throwing()).get() == std::future_errc::broken_promise);
+  }
+
+  SECTION("inline executor") {
+    rms::InlineExecutor executor;
+    auto task = [](rms::InlineExecutor& executor) -> Task<int> {
+      co_await rms::schedule(executor);
+      co_return 7;
+    };
+    REQUIRE(7 == rms::start(task(executor)).get().value());
+  }
+
+  SECTION("thread pool") {
+    rms::ThreadPool pool(2U);
+    for (int i = 0; i < 100; ++i) {
+      std::thread::id thread;
+      auto future = rms::start(is_admin_on_pool(pool, db_manager, &thread));
+      REQUIRE_FALSE(std::move(future).get().value());
+      REQUIRE(thread != std::this_thread::get_id());
+    }
+  }
+}
@@ -0,0 +1,164 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#include "thread_pool.h"
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "value_or_error.h"
+#include "work_stealing_deque.h"
+
+using rms::ThreadPool;
+using rms::ValueOrError;
+using rms::detail::WorkStealingDeque;
+
+namespace {
+
+// Every task posts two children until depth is exhausted
+void spawn(ThreadPool& pool, std::atomic<int>& count, int depth) {
+  count.fetch_add(1, std::memory_order_relaxed);
+  if (depth == 0) {
+    return;
+  }
+  for (int i = 0; i < 2; ++i) {
+    pool.post([&pool, &count, depth] { spawn(pool, count, depth - 1); });
+  }
+}
+
+}  // namespace
+
+TEST_CASE("Work stealing deque", "[ThreadPool]") {
+  SECTION("owner pops newest, thief steals oldest") {
+    WorkStealingDeque<int> deque(2U);
+    int items[5] = {0, 1, 2, 3, 4};
+    REQUIRE(deque.empty());
+    REQUIRE(nullptr == deque.pop());
+    REQUIRE(nullptr == deque.steal());
+    for (auto& item : items) {
+      deque.push(&item);
+    }
+    REQUIRE_FALSE(deque.empty());
+    REQUIRE(&items[4] == deque.pop());
+    REQUIRE(&items[0] == deque.steal());
+    REQUIRE(&items[3] == deque.pop());
+    REQUIRE(&items[1] == deque.steal());
+    REQUIRE(&items[2] == deque.pop());
+    REQUIRE(nullptr == deque.pop());
+    REQUIRE(deque.empty());
+  }
+
+  SECTION("every item is taken once") {
+    constexpr std::size_t Count = 100000U;
+    std::vector<std::atomic<int>> taken(Count);
+    std::vector<std::size_t> items(Count);
+    WorkStealingDeque<std::size_t> deque;
+    std::atomic<bool> done{false};
+
+    auto const take = [&taken](std::size_t* item) {
+      taken[*item].fetch_add(1, std::memory_order_relaxed);
+    };
+    std::vector<std::thread> thieves;
+    for (int i = 0; i < 3; ++i) {
+      thieves.emplace_back([&deque, &done, &take] {
+        while (!done.load(std::memory_order_acquire) || !deque.empty()) {
+          if (auto* item = deque.steal()) {
+            take(item);
+          }
+        }
+      });
+    }
+    for (std::size_t i = 0U; i < Count; ++i) {
+      items[i] = i;
+      deque.push(&items[i]);
+      if (i % 3U == 0U) {
+        if (auto* item = deque.pop()) {
+          take(item);
+        }
+      }
+    }
+    while (auto* item = deque.pop()) {
+      take(item);
+    }
+    done.store(true, std::memory_order_release);
+    for (auto& thief : thieves) {
+      thief.join();
+    }
+    std::size_t once = 0U;
+    for (auto const& count : taken) {
+      once += count.load() == 1 ? 1U : 0U;
+    }
+    REQUIRE(Count == once);
+  }
+}
+
+TEST_CASE("Thread pool", "[ThreadPool]") {
+  SECTION("posted tasks are run before destruction") {
+    std::atomic<int> sum{0};
+    {
+      ThreadPool pool(2U);
+      REQUIRE(2U == pool.size());
+      REQUIRE_FALSE(pool.in_worker());
+      for (int i = 1; i <= 100; ++i) {
+        pool.post([&sum, i] { sum.fetch_add(i, std::memory_order_relaxed); });
+      }
+    }
+    REQUIRE(5050 == sum.load());
+  }
+
+  SECTION("tasks posted by tasks") {
+    std::atomic<int> count{0};
+    {
+      ThreadPool pool(4U);
+      pool.post([&pool, &count] { spawn(pool, count, 12); });
+    }
+    REQUIRE((1 << 13) - 1 == count.load());
+  }
+
+  SECTION("result is passed to handler") {
+    std::atomic<int> values{0};
+    std::atomic<int> errors{0};
+    std::atomic<bool> in_worker{false};
+    {
+      ThreadPool pool(2U);
+      for (int i = 0; i < 10; ++i) {
+        pool.post(
+            [i]() -> ValueOrError<std::string> {
+              if (i % 2 == 0) {
+                return std::make_error_code(std::errc::timed_out);
+              }
+              return std::string("value");
+            },
+            [&](ValueOrError<std::string>&& result) {
+              in_worker.store(pool.in_worker());
+              if (result) {
+                values.fetch_add(1);
+              } else if (result.error() == std::errc::timed_out) {
+                errors.fetch_add(1);
+              }
+            });
+      }
+    }
+    REQUIRE(5 == values.load());
+    REQUIRE(5 == errors.load());
+    REQUIRE(in_worker.load());
+  }
+
+  SECTION("parked workers are woken") {
+    ThreadPool pool(2U);
+    for (int round = 0; round < 3; ++round) {
+      // Let the workers park
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      std::atomic<bool> done{false};
+      pool.post([&done] { done.store(true); });
+      while (!done.load()) {
+        std::this_thread::yield();
+      }
+    }
+  }
+}
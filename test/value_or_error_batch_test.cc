@@ -0,0 +1,135 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+#include "value_or_error_batch.h"
+
+#include <catch2/catch.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "compact_error.h"
+#include "value_or_error.h"
+
+using rms::ValueOrError;
+using rms::ValueOrErrorBatch;
+
+namespace {
+
+// Every Period-th element fails
+template <typename E = std::error_code>
+ValueOrErrorBatch<int, E> make_batch(std::size_t size, std::size_t period) {
+  ValueOrErrorBatch<int, E> batch;
+  batch.reserve(size);
+  for (std::size_t i = 0U; i < size; ++i) {
+    if (i % period == 0U) {
+      batch.push_error(std::make_error_code(std::errc::invalid_argument));
+    } else {
+      batch.emplace_value(static_cast<int>(i));
+    }
+  }
+  return batch;
+}
+
+}  // namespace
+
+TEST_CASE("ValueOrErrorBatch", "[ValueOrErrorBatch]") {
+  SECTION("empty") {
+    ValueOrErrorBatch<int> batch;
+    REQUIRE(batch.empty());
+    REQUIRE(0U == batch.value_count());
+    bool called = false;
+    batch.for_each_value([&called](std::size_t, int) { called = true; });
+    batch.for_each_error(
+        [&called](std::size_t, std::error_code) { called = true; });
+    REQUIRE_FALSE(called);
+  }
+
+  SECTION("counts and access") {
+    auto const batch = make_batch(200U, 7U);
+    REQUIRE(200U == batch.size());
+    REQUIRE(29U == batch.error_count());
+    REQUIRE(171U == batch.value_count());
+    REQUIRE_FALSE(batch.has_value(0U));
+    REQUIRE(batch.has_value(1U));
+    REQUIRE(1 == batch.value(1U));
+    REQUIRE(!batch.error(1U));
+    REQUIRE(batch.error(196U) == std::errc::invalid_argument);
+    REQUIRE(4U == batch.value_mask().size());
+  }
+
+  SECTION("iterate successes and failures") {
+    auto batch = make_batch(130U, 3U);
+    std::vector<std::size_t> values;
+    batch.for_each_value([&values](std::size_t index, int& value) {
+      REQUIRE(static_cast<int>(index) == value);
+      values.push_back(index);
+    });
+    std::vector<std::size_t> errors;
+    batch.for_each_error([&errors](std::size_t index, std::error_code error) {
+      REQUIRE(error == std::errc::invalid_argument);
+      errors.push_back(index);
+    });
+    REQUIRE(batch.value_count() == values.size());
+    REQUIRE(batch.error_count() == errors.size());
+    REQUIRE(1U == values.front());
+    REQUIRE(128U == values.back());
+    REQUIRE(129U == errors.back());
+    for (auto const index : errors) {
+      REQUIRE(0U == index % 3U);
+    }
+  }
+
+  SECTION("from and to ValueOrError") {
+    ValueOrErrorBatch<std::string> batch;
+    ValueOrError<std::string> text(std::string("text"));
+    batch.push_back(text);
+    batch.push_back(ValueOrError<std::string>(std::string("moved")));
+    batch.push_back(
+        ValueOrError<std::string>(std::make_error_code(std::errc::timed_out)));
+
+    REQUIRE("text" == text.value());
+    REQUIRE("text" == batch[0U].value());
+    batch[0U].value() += "!";
+    REQUIRE("text!" == batch.values()[0U]);
+    REQUIRE(batch[2U] == std::errc::timed_out);
+
+    auto moved = batch.extract(1U);
+    REQUIRE("moved" == moved.value());
+    REQUIRE(batch.has_value(1U));
+    REQUIRE(2U == batch.value_count());
+    REQUIRE(batch.extract(2U) == std::errc::timed_out);
+  }
+
+  SECTION("empty result is rejected") {
+    ValueOrErrorBatch<std::string> batch;
+    ValueOrError<std::string> empty;
+    REQUIRE_THROWS_AS(batch.push_back(empty), std::logic_error);
+    ValueOrError<std::string> extracted(std::string("text"));
+    REQUIRE("text" == extracted.extract());
+    REQUIRE_THROWS_AS(batch.push_back(std::move(extracted)), std::logic_error);
+    REQUIRE(batch.empty());
+    REQUIRE(0U == batch.error_count());
+  }
+
+  SECTION("const access") {
+    auto const batch = make_batch(10U, 5U);
+    REQUIRE(3 == batch[3U].value());
+    REQUIRE(batch[5U] == std::errc::invalid_argument);
+  }
+
+  SECTION("compact error") {
+    auto const batch = make_batch<rms::CompactErrorCode>(70U, 10U);
+    REQUIRE(7U == batch.error_count());
+    REQUIRE(batch.error(60U) == std::errc::invalid_argument);
+  }
+
+  SECTION("clear") {
+    auto batch = make_batch(100U, 2U);
+    batch.clear();
+    REQUIRE(batch.empty());
+    REQUIRE(batch.value_mask().empty());
+    REQUIRE(0U == batch.error_count());
+  }
+}
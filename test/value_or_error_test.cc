@@ -3,6 +3,12 @@
 
 #include <catch2/catch.hpp>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "try.h"
 
 namespace {
 
@@ -55,6 +61,38 @@ class Foo {
   int m_data = 0;
 };
 
+// Move throws when asked to, counts alive instances
+class ThrowingMove {
+ public:
+  explicit ThrowingMove(bool throw_on_move) : m_throw_on_move(throw_on_move) {
+    ++Alive;
+  }
+
+  ThrowingMove(ThrowingMove const& other)
+      : m_throw_on_move(other.m_throw_on_move) {
+    ++Alive;
+  }
+
+  ThrowingMove(ThrowingMove&& other) : m_throw_on_move(other.m_throw_on_move) {
+    if (m_throw_on_move) {
+      throw std::runtime_error("move");
+    }
+    ++Alive;
+  }
+
+  ThrowingMove& operator=(ThrowingMove const&) = default;
+  ThrowingMove& operator=(ThrowingMove&&) = default;
+
+  ~ThrowingMove() { --Alive; }
+
+  static int Alive;
+
+ private:
+  bool m_throw_on_move;
+};
+
+int ThrowingMove::Alive = 0;
+
 using ErrorOrFoo = rms::ValueOrError<Foo>;
 using UniqueFoo = std::unique_ptr<Foo>;
 using UniqueFoos = std::vector<UniqueFoo>;
@@ -79,13 +117,60 @@ rms::ValueOrError<int> get_int_data(int value, bool make_error) {
   return value;
 }
 
+rms::ValueOrError<void> check_data(int value, bool make_error) {
+  VOE_TRY(get_int_data(value, make_error));
+  return {};
+}
+
+rms::ValueOrError<Foo&> find_foo(std::vector<Foo>& foos, std::size_t index) {
+  if (index >= foos.size()) {
+    return make_error_code(std::errc::result_out_of_range);
+  }
+  return foos[index];
+}
+
+rms::ValueOrError<int> get_foo_data(std::vector<Foo>& foos,
+                                    std::size_t index) {
+  VOE_TRY_EXTRACT(foo, find_foo(foos, index));
+  return foo.get_data();
+}
+
 }  // namespace
 
+#if VOE_RUNTIME_CHECKS
+// Unhandled errors are detected in the dtor, the layout is the same
+static_assert(!std::is_trivially_destructible<rms::ValueOrError<int>>::value,
+              "ValueOrError<int> should check unhandled error");
+static_assert(!std::is_trivially_destructible<rms::ValueOrError<void>>::value,
+              "ValueOrError<void> should check unhandled error");
+#else
+static_assert(std::is_trivially_copyable<rms::ValueOrError<int>>::value,
+              "ValueOrError<int> should be trivially copyable");
+static_assert(std::is_trivially_copyable<rms::ValueOrError<bool>>::value,
+              "ValueOrError<bool> should be trivially copyable");
+static_assert(std::is_trivially_copyable<rms::ValueOrError<Foo&>>::value,
+              "ValueOrError<Foo&> should be trivially copyable");
+#endif
+static_assert(sizeof(rms::ValueOrError<int>) <= 16U,
+              "ValueOrError<int> should fit into two registers");
+static_assert(!std::is_trivially_copyable<ErrorOrFoo>::value,
+              "ValueOrError<Foo> should not be trivially copyable");
+static_assert(sizeof(rms::ValueOrError<void>) == sizeof(std::error_code),
+              "ValueOrError<void> should be as small as the error");
+static_assert(std::is_nothrow_move_constructible<ErrorOrFoo>::value,
+              "ValueOrError<Foo> should be nothrow move constructible");
+static_assert(std::is_nothrow_move_assignable<ErrorOrFoo>::value,
+              "ValueOrError<Foo> should be nothrow move assignable");
+static_assert(
+    std::is_nothrow_move_constructible<rms::ValueOrError<std::string>>::value,
+    "ValueOrError<std::string> should be nothrow move constructible");
+
 TEST_CASE("Tests of ValueOrError class", "ValueOrError") {
   Foo::CTorCnt = 0;
   Foo::CopyCTorCnt = 0;
   Foo::MoveCTorCnt = 0;
   Foo::MoveAssignCnt = 0;
+  Foo::CopyAssignCnt = 0;
   Foo::DTorCnt = 0;
 
   SECTION("Create with error") {
@@ -158,10 +243,73 @@ TEST_CASE("Tests of ValueOrError class", "ValueOrError") {
 
     REQUIRE(1U == Foo::CTorCnt);
     REQUIRE(0U == Foo::CopyCTorCnt);
-    REQUIRE(2U == Foo::MoveCTorCnt);
+    REQUIRE(0U == Foo::MoveCTorCnt);
     REQUIRE(0U == Foo::MoveAssignCnt);
     REQUIRE(0U == Foo::CopyAssignCnt);
-    REQUIRE(3U == Foo::DTorCnt);
+    REQUIRE(1U == Foo::DTorCnt);
+  }
+
+  SECTION("Emplace over error") {
+    {
+      auto result =
+          ErrorOrFoo(std::make_error_code(std::errc::invalid_argument));
+      REQUIRE(!result);
+
+      auto& value = result.emplace(DefaultValue);
+      REQUIRE(result);
+      REQUIRE(&value == &result.value());
+      REQUIRE(DefaultValue == value.get_data());
+    }
+
+    REQUIRE(1U == Foo::CTorCnt);
+    REQUIRE(0U == Foo::CopyCTorCnt);
+    REQUIRE(0U == Foo::MoveCTorCnt);
+    REQUIRE(1U == Foo::DTorCnt);
+  }
+
+  SECTION("Create in place") {
+    {
+      auto result = ErrorOrFoo(rms::in_place, DefaultValue);
+      REQUIRE(result);
+      REQUIRE(DefaultValue == result->get_data());
+
+      auto made = rms::make_value_or_error<Foo>(DefaultValue);
+      REQUIRE(made);
+      REQUIRE(DefaultValue == made->get_data());
+    }
+
+    REQUIRE(2U == Foo::CTorCnt);
+    REQUIRE(0U == Foo::CopyCTorCnt);
+    REQUIRE(0U == Foo::MoveCTorCnt);
+    REQUIRE(0U == Foo::MoveAssignCnt);
+    REQUIRE(2U == Foo::DTorCnt);
+  }
+
+  SECTION("Create in place with initializer list") {
+    auto result = rms::make_value_or_error<std::vector<int>>({1, 2, 3});
+    REQUIRE(result);
+    REQUIRE(3U == result->size());
+    REQUIRE(3 == result->back());
+
+    result.emplace({DefaultValue});
+    REQUIRE(1U == result->size());
+    REQUIRE(DefaultValue == result->front());
+  }
+
+  SECTION("Converting copy and move construct value once") {
+    {
+      auto const number = rms::ValueOrError<int>(DefaultValue);
+      auto copied = ErrorOrFoo(number);
+      REQUIRE(DefaultValue == copied->get_data());
+
+      auto moved = ErrorOrFoo(rms::ValueOrError<int>(DefaultValue + 1));
+      REQUIRE(DefaultValue + 1 == moved->get_data());
+    }
+
+    REQUIRE(2U == Foo::CTorCnt);
+    REQUIRE(0U == Foo::CopyCTorCnt);
+    REQUIRE(0U == Foo::MoveCTorCnt);
+    REQUIRE(2U == Foo::DTorCnt);
   }
 
   SECTION("Implicit create") {
@@ -200,10 +348,10 @@ TEST_CASE("Tests of ValueOrError class", "ValueOrError") {
 
     REQUIRE(1U == Foo::CTorCnt);  // Was emplaced explicitly
     REQUIRE(0U == Foo::CopyCTorCnt);
-    REQUIRE(2U == Foo::MoveCTorCnt);
+    REQUIRE(1U == Foo::MoveCTorCnt);
     REQUIRE(0U == Foo::MoveAssignCnt);
     REQUIRE(0U == Foo::CopyAssignCnt);
-    REQUIRE(3U == Foo::DTorCnt);  // All were destroyed
+    REQUIRE(2U == Foo::DTorCnt);  // All were destroyed
   }
 
   SECTION("Create with unique value") {
@@ -286,6 +434,16 @@ TEST_CASE("Tests of ValueOrError class", "ValueOrError") {
     REQUIRE(value2.value());
   }
 
+  SECTION("Trivially copyable keeps error on copy") {
+    auto const value = get_int_data(DefaultValue, true);
+    auto copy = value;
+
+    REQUIRE(!copy);
+    REQUIRE(!copy.has_value());
+    REQUIRE(copy.error() == std::errc::no_such_file_or_directory);
+    REQUIRE(copy.error() == value.error());
+  }
+
   SECTION("Error or move with value") {
     auto value = ErrorOrUniqueFoo(std::make_unique<Foo>(DefaultValue));
 
@@ -313,6 +471,74 @@ TEST_CASE("Tests of ValueOrError class", "ValueOrError") {
     REQUIRE(moved.error());
   }
 
+  SECTION("Copy with value") {
+    {
+      auto const result = ErrorOrFoo(Foo(DefaultValue));
+      auto copy = result;
+      REQUIRE(copy);
+      REQUIRE(copy.has_value());
+      REQUIRE(DefaultValue == copy->get_data());
+      REQUIRE(result.has_value());
+    }
+
+    REQUIRE(1U == Foo::CTorCnt);
+    REQUIRE(1U == Foo::CopyCTorCnt);
+    REQUIRE(1U == Foo::MoveCTorCnt);
+    REQUIRE(3U == Foo::DTorCnt);
+  }
+
+  SECTION("Move assign error over value") {
+    auto value = ErrorOrFoo(Foo(DefaultValue));
+    value = ErrorOrFoo(std::make_error_code(std::errc::invalid_argument));
+
+    REQUIRE(!value);
+    REQUIRE(!value.has_value());
+    REQUIRE(value.error() == std::errc::invalid_argument);
+  }
+
+  SECTION("Vector growth moves values") {
+    std::size_t const cnt = 100U;
+    {
+      std::vector<ErrorOrFoo> results;
+      for (std::size_t i = 0U; i < cnt; ++i) {
+        results.emplace_back(Foo(DefaultValue));
+      }
+      for (auto const& result : results) {
+        REQUIRE(DefaultValue == result->get_data());
+      }
+    }
+
+    REQUIRE(cnt == Foo::CTorCnt);
+    REQUIRE(0U == Foo::CopyCTorCnt);
+    REQUIRE(0U == Foo::CopyAssignCnt);
+  }
+
+  SECTION("Swap value and error") {
+    auto value = ErrorOrFoo(Foo(DefaultValue));
+    auto error =
+        ErrorOrFoo(std::make_error_code(std::errc::no_such_file_or_directory));
+
+    swap(value, error);
+
+    REQUIRE(!value);
+    REQUIRE(value.error() == std::errc::no_such_file_or_directory);
+    REQUIRE(error.has_value());
+    REQUIRE(DefaultValue == error->get_data());
+    REQUIRE(0U == Foo::CopyCTorCnt);
+  }
+
+  SECTION("Swap values") {
+    auto first = ErrorOrFoo(Foo(DefaultValue));
+    auto second = ErrorOrFoo(Foo(DefaultValue + 1));
+
+    first.swap(second);
+
+    REQUIRE(DefaultValue + 1 == first->get_data());
+    REQUIRE(DefaultValue == second->get_data());
+    REQUIRE(0U == Foo::CopyCTorCnt);
+    REQUIRE(0U == Foo::CopyAssignCnt);
+  }
+
   SECTION("To stream") {
     rms::ValueOrError<std::string> value1;
     REQUIRE(!value1.has_value());
@@ -492,3 +718,267 @@ TEST_CASE("Tests of ValueOrError class", "ValueOrError") {
     REQUIRE(result.value().get_data() == DefaultValue + 3);
   }
 }
+
+TEST_CASE("Combinators of ValueOrError", "ValueOrError") {
+  auto const invalid = std::make_error_code(std::errc::invalid_argument);
+  Foo::CopyCTorCnt = 0;
+
+  SECTION("Map value") {
+    auto result = ErrorOrFoo(Foo{DefaultValue}).map([](Foo&& foo) {
+      return foo.get_data() + 1;
+    });
+    static_assert(std::is_same<rms::ValueOrError<int>, decltype(result)>::value,
+                  "map() must wrap result of F");
+    REQUIRE(DefaultValue + 1 == result.value());
+  }
+
+  SECTION("Map skips F on error") {
+    bool called = false;
+    auto result = ErrorOrFoo(invalid).map([&called](Foo const& foo) {
+      called = true;
+      return foo.get_data();
+    });
+    REQUIRE_FALSE(called);
+    REQUIRE(result == std::errc::invalid_argument);
+  }
+
+  SECTION("Map to void") {
+    int data = 0;
+    rms::ValueOrError<void> result = get_int_data(DefaultValue, false).map(
+        [&data](int value) { data = value; });
+    REQUIRE(result);
+    REQUIRE(DefaultValue == data);
+  }
+
+  SECTION("Rvalue chains don't copy the value") {
+    auto const pass = [](Foo&& foo) { return std::move(foo); };
+    auto const wrap = [](Foo&& foo) { return ErrorOrFoo(std::move(foo)); };
+    auto result = ErrorOrFoo(Foo{DefaultValue})
+                      .map(pass)
+                      .then(wrap)
+                      .map(pass)
+                      .value_or(Foo{});
+    REQUIRE(DefaultValue == result.get_data());
+    REQUIRE(0U == Foo::CopyCTorCnt);
+  }
+
+  SECTION("Rvalue chains accept F taking T&") {
+    auto const increment = [](Foo& foo) {
+      foo.set_data(foo.get_data() + 1);
+      return ErrorOrFoo(std::move(foo));
+    };
+    auto const data = [](Foo& foo) { return foo.get_data(); };
+    auto result = ErrorOrFoo(Foo{DefaultValue})
+                      .then(increment)
+                      .then(increment)
+                      .map(data);
+    REQUIRE(DefaultValue + 2 == result.value());
+    REQUIRE(0U == Foo::CopyCTorCnt);
+  }
+
+  SECTION("Lvalue is not moved") {
+    ErrorOrFoo source(Foo{DefaultValue});
+    auto result = source.map([](Foo const& foo) { return foo.get_data(); });
+    REQUIRE(DefaultValue == result.value());
+    REQUIRE(DefaultValue == source.value().get_data());
+    REQUIRE(DefaultValue == source.value_or(Foo{}).get_data());
+    REQUIRE(1U == Foo::CopyCTorCnt);
+  }
+
+  SECTION("Map error") {
+    auto const to_timeout = [](std::error_code error) {
+      REQUIRE(error == std::errc::invalid_argument);
+      return std::errc::timed_out;
+    };
+    REQUIRE(ErrorOrFoo(invalid).map_error(to_timeout) == std::errc::timed_out);
+    REQUIRE(check_data(DefaultValue, true)
+                .map_error([](std::error_code) { return std::errc::timed_out; })
+                .error() == std::errc::timed_out);
+
+    auto result = ErrorOrFoo(Foo{DefaultValue}).map_error(to_timeout);
+    REQUIRE(DefaultValue == result.value().get_data());
+    REQUIRE(0U == Foo::CopyCTorCnt);
+  }
+
+  SECTION("Or else recovers from error") {
+    auto result = ErrorOrFoo(invalid).or_else([](std::error_code) {
+      return ErrorOrFoo(Foo{DefaultValue});
+    });
+    REQUIRE(DefaultValue == result.value().get_data());
+
+    bool called = false;
+    auto value = get_int_data(DefaultValue, false)
+                     .or_else([&called](std::error_code) {
+                       called = true;
+                       return rms::ValueOrError<int>(0);
+                     });
+    REQUIRE_FALSE(called);
+    REQUIRE(DefaultValue == value.value());
+  }
+
+  SECTION("Or else observes error") {
+    std::error_code observed;
+    auto result = ErrorOrFoo(invalid).or_else(
+        [&observed](std::error_code error) { observed = error; });
+    REQUIRE(observed == std::errc::invalid_argument);
+    REQUIRE(result == std::errc::invalid_argument);
+  }
+
+  SECTION("Value or default") {
+    REQUIRE(DefaultValue ==
+            get_int_data(DefaultValue, false).value_or(DefaultValue + 1));
+    REQUIRE(DefaultValue + 1 ==
+            get_int_data(DefaultValue, true).value_or(DefaultValue + 1));
+    rms::ValueOrError<std::string> text(std::string("text"));
+    REQUIRE("text" == std::move(text).value_or("default"));
+    REQUIRE_FALSE(text.has_value());
+  }
+
+  SECTION("Value or else is lazy") {
+    bool called = false;
+    auto const fallback = [&called]() {
+      called = true;
+      return Foo{DefaultValue + 1};
+    };
+    REQUIRE(DefaultValue ==
+            ErrorOrFoo(Foo{DefaultValue}).value_or_else(fallback).get_data());
+    REQUIRE_FALSE(called);
+    REQUIRE(DefaultValue + 1 ==
+            ErrorOrFoo(invalid).value_or_else(fallback).get_data());
+    REQUIRE(called);
+    REQUIRE(std::errc::invalid_argument ==
+            static_cast<std::errc>(
+                rms::ValueOrError<int>(invalid).value_or_else(
+                    [](std::error_code error) { return error.value(); })));
+  }
+}
+
+TEST_CASE("Tests of ValueOrError<void>", "ValueOrError") {
+  SECTION("Default is success") {
+    rms::ValueOrError<void> result;
+    REQUIRE(result);
+    REQUIRE(result.has_value());
+    REQUIRE(!result.error());
+    REQUIRE_NOTHROW(result.value());
+  }
+
+  SECTION("Create with error") {
+    rms::ValueOrError<void> result{
+        std::make_error_code(std::errc::invalid_argument)};
+    REQUIRE(!result);
+    REQUIRE(!result.has_value());
+    REQUIRE(result == std::errc::invalid_argument);
+    REQUIRE_THROWS_AS(result.value(), std::logic_error);
+  }
+
+  SECTION("Propagate with try") {
+    REQUIRE(check_data(DefaultValue, false));
+    REQUIRE(check_data(DefaultValue, true).error() ==
+            std::errc::no_such_file_or_directory);
+  }
+
+  SECTION("Then") {
+    auto result = check_data(DefaultValue, false).then([]() {
+      return get_int_data(DefaultValue, false);
+    });
+    REQUIRE(result);
+    REQUIRE(DefaultValue == result.value());
+
+    auto failed = check_data(DefaultValue, true).then([]() {
+      return get_int_data(DefaultValue, false);
+    });
+    REQUIRE(!failed);
+    REQUIRE(failed.error() == std::errc::no_such_file_or_directory);
+
+    auto checked = get_int_data(DefaultValue, false).then([](int value) {
+      return check_data(value, false);
+    });
+    REQUIRE(checked);
+  }
+}
+
+TEST_CASE("Tests of ValueOrError<T&>", "ValueOrError") {
+  std::vector<Foo> foos(2U);
+  foos[1].set_data(DefaultValue);
+  Foo::CopyCTorCnt = 0;
+  Foo::CopyAssignCnt = 0;
+
+  SECTION("Borrow value") {
+    auto result = find_foo(foos, 1U);
+    REQUIRE(result);
+    REQUIRE(&foos[1] == &result.value());
+    REQUIRE(DefaultValue == result->get_data());
+
+    result->set_data(DefaultValue + 1);
+    REQUIRE(DefaultValue + 1 == foos[1].get_data());
+
+    auto copy = result;
+    REQUIRE(&foos[1] == &*copy);
+    REQUIRE(0U == Foo::CopyCTorCnt);
+  }
+
+  SECTION("Create with error") {
+    auto result = find_foo(foos, 2U);
+    REQUIRE(!result);
+    REQUIRE(result.error() == std::errc::result_out_of_range);
+    REQUIRE_THROWS_AS(result.value(), std::logic_error);
+  }
+
+  SECTION("Convert to const reference") {
+    rms::ValueOrError<Foo const&> result = find_foo(foos, 1U);
+    REQUIRE(&foos[1] == &result.value());
+  }
+
+  SECTION("Propagate with try extract") {
+    REQUIRE(DefaultValue == get_foo_data(foos, 1U).value());
+    REQUIRE(get_foo_data(foos, 2U).error() == std::errc::result_out_of_range);
+    REQUIRE(0U == Foo::CopyCTorCnt);
+  }
+
+  SECTION("Then") {
+    auto result = find_foo(foos, 1U).then(
+        [](Foo& foo) { return rms::ValueOrError<int>(foo.get_data()); });
+    REQUIRE(DefaultValue == result.value());
+    REQUIRE(0U == Foo::CopyCTorCnt);
+  }
+
+  SECTION("Map and value or") {
+    Foo fallback;
+    auto const get_data = [](Foo& foo) { return foo.get_data(); };
+    REQUIRE(DefaultValue == find_foo(foos, 1U).map(get_data).value());
+    REQUIRE(&fallback == &find_foo(foos, 2U).value_or(fallback));
+    REQUIRE(find_foo(foos, 2U).map_error([](std::error_code) {
+      return std::errc::invalid_argument;
+    }) == std::errc::invalid_argument);
+    REQUIRE(0U == Foo::CopyCTorCnt);
+  }
+
+  SECTION("To stream") {
+    std::string data = "DATA";
+    rms::ValueOrError<std::string&> result = data;
+    std::stringstream ss;
+    ss << result;
+    REQUIRE("DATA" == ss.str());
+  }
+}
+
+TEST_CASE("Assignment with throwing move", "ValueOrError") {
+  using Result = rms::ValueOrError<ThrowingMove>;
+  {
+    Result result(ThrowingMove(false));
+    Result throwing(rms::in_place, true);
+    REQUIRE_THROWS_AS(result = std::move(throwing), std::runtime_error);
+    REQUIRE_FALSE(result.has_value());
+    REQUIRE(throwing.has_value());
+
+    result = Result(ThrowingMove(false));
+    REQUIRE_THROWS_AS(result = throwing, std::runtime_error);
+    REQUIRE_FALSE(result.has_value());
+
+    Result error(std::make_error_code(std::errc::timed_out));
+    REQUIRE_THROWS_AS(error.swap(throwing), std::runtime_error);
+    REQUIRE(throwing.has_value());
+    error.ignore();
+  }
+  REQUIRE(0 == ThrowingMove::Alive);
+}
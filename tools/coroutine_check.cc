@@ -0,0 +1,181 @@
+// Copyright [2019] <Malinovsky Rodion> (rodionmalino@gmail.com)
+// Run by CMake when VOE_COROUTINES is on. Checks code generation for
+// coroutines which coroutine.h relies on and which some compilers (e.g.
+// GCC 12) get wrong. Prints the result of each check, exits with non-zero
+// code if any fails. A check which crashes fails the whole run. Checks are
+// run in order, so a crash hides the results of the checks after it.
+#include <coroutine>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace {
+
+// Frames are never reused, so a frame freed twice is counted, not a crash
+alignas(std::max_align_t) unsigned char arena[16384];
+std::size_t arena_used = 0U;
+int frames = 0;
+
+struct FrameCounter {
+  static void* operator new(std::size_t size) {
+    auto const aligned = (size + alignof(std::max_align_t) - 1U) &
+                         ~(alignof(std::max_align_t) - 1U);
+    if (arena_used + aligned > sizeof(arena)) {
+      std::abort();
+    }
+    void* const frame = arena + arena_used;
+    arena_used += aligned;
+    ++frames;
+    return frame;
+  }
+
+  static void operator delete(void*) { --frames; }
+};
+
+// Coroutine whose return object is converted after the body
+struct Result {
+  int value;
+};
+
+struct ThrowingReturnObject {
+  // NOLINTNEXTLINE(runtime/explicit)
+  operator Result() const { throw std::runtime_error("conversion"); }
+};
+
+struct ConvertedPromise : FrameCounter {
+  ThrowingReturnObject get_return_object() { return {}; }
+  std::suspend_never initial_suspend() noexcept { return {}; }
+  std::suspend_never final_suspend() noexcept { return {}; }
+  void return_value(int) {}
+  void unhandled_exception() {}
+};
+
+// Not trivially destructible, so it is kept in the frame
+struct Temporary {
+  ~Temporary() {}
+};
+
+struct Failing {
+  bool await_ready() const noexcept { return false; }
+  void await_suspend(std::coroutine_handle<>) const noexcept {}
+  bool await_resume() const noexcept { return false; }
+
+  Temporary& awaited;
+};
+
+// Stops at an awaited error without finishing, as coroutine.h does
+struct Suspending {
+  struct promise_type : FrameCounter {
+    Suspending get_return_object() {
+      return Suspending{
+          std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_value(int) {}
+    void unhandled_exception() {}
+    Failing await_transform(Temporary&& awaited) noexcept { return {awaited}; }
+  };
+
+  std::coroutine_handle<promise_type> handle;
+};
+
+// Started on resume as Task of task.h
+struct Lazy {
+  struct promise_type : FrameCounter {
+    Lazy get_return_object() {
+      return Lazy{std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_value(int result) { value = result; }
+    void unhandled_exception() {}
+
+    int value = 0;
+  };
+
+  std::coroutine_handle<promise_type> handle;
+};
+
+struct Ready {
+  bool await_ready() const noexcept { return true; }
+  void await_suspend(std::coroutine_handle<>) const noexcept {}
+  bool await_resume() const noexcept { return true; }
+};
+
+}  // namespace
+
+namespace std {
+template <>
+struct coroutine_traits<Result> {
+  using promise_type = ConvertedPromise;
+};
+}  // namespace std
+
+namespace {
+
+Result finished() { co_return 1; }
+
+// The conversion throws after the frame is freed by the coroutine, as when
+// coroutine.h rethrows an exception of the body
+bool throwing_conversion_frees_frame_once() {
+  int const before = frames;
+  try {
+    static_cast<void>(finished());
+  } catch (std::runtime_error const&) {
+  }
+  return frames == before;
+}
+
+Suspending suspend_in_condition() {
+  if (!(co_await Temporary{})) {
+    co_return 1;
+  }
+  co_return 2;
+}
+
+// Frame suspended in the condition of an if statement is destroyed later
+bool suspended_condition_is_destroyed() {
+  int const before = frames;
+  auto suspending = suspend_in_condition();
+  suspending.handle.destroy();
+  return frames == before;
+}
+
+Lazy await_in_condition() {
+  if (co_await Ready{}) {
+    co_return 1;
+  }
+  co_return 2;
+}
+
+// Lazily started coroutine with co_await in the condition of an if
+// statement runs to the end
+bool lazy_condition_completes() {
+  auto lazy = await_in_condition();
+  lazy.handle.resume();
+  bool const completed = lazy.handle.done() && lazy.handle.promise().value == 1;
+  lazy.handle.destroy();
+  return completed;
+}
+
+bool run(bool (*check)(), char const* name) {
+  std::printf("%s: ", name);
+  std::fflush(stdout);
+  bool const passed = check();
+  std::printf("%s\n", passed ? "ok" : "failed");
+  return passed;
+}
+
+}  // namespace
+
+int main() {
+  bool passed = run(throwing_conversion_frees_frame_once,
+                    "exception from conversion of return object");
+  passed &= run(suspended_condition_is_destroyed,
+                "destroy of frame suspended in if condition");
+  passed &= run(lazy_condition_completes,
+                "lazy coroutine with co_await in if condition");
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}